@@ -0,0 +1,33 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <stdint.h>
+
+// Calendar buckets for time-based reduction of the series
+typedef enum
+{
+    BUCKET_DAY,
+    BUCKET_WEEK, // ISO weeks, starting on Monday
+    BUCKET_MONTH,
+} BucketSize;
+
+// Running statistics of one bucket.
+// Mean and variance use Welford's update, which needs no second pass over the
+// data and does not lose precision the way sum / sum-of-squares does.
+typedef struct
+{
+    int64_t start; // First second of the bucket
+    long count;
+    float min;
+    float max;
+    double mean;
+    double m2; // Sum of squared differences from the mean
+} BucketStats;
+
+int64_t bucket_start(int64_t timestamp, BucketSize bucket_size);      // Start of the bucket that holds 'timestamp'
+void bucket_stats_init(BucketStats *stats, int64_t start);            // Empty bucket starting at 'start'
+void bucket_stats_add(BucketStats *stats, float value);               // Add one sample
+double bucket_stats_stddev(const BucketStats *stats);                 // Sample standard deviation
+int aggregate_csv(const char *input_filename, const char *output_filename, BucketSize bucket_size); // Streaming aggregation
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "filter.h"
+
+#define SERIES_MAGIC "FSER" // First four bytes of every binary series file
+#define SERIES_VERSION 1
+
+// How the value column is stored
+typedef enum
+{
+    VALUE_FLOAT32, // 4 bytes per sample, exact
+    VALUE_INT16,   // 2 bytes per sample, value = raw * value_scale + value_offset
+} ValueEncoding;
+
+/*
+ * Binary columnar series file (little-endian):
+ *
+ *   [SeriesHeader, 64 bytes]
+ *   [timestamp column: num_samples x int64, delta-encoded]
+ *   [value column: num_samples x float32 or int16]
+ *
+ * The metadata that write_csv repeats on every row (the filter name) is
+ * stored once in the header. Timestamp i is first_timestamp plus the sum of
+ * deltas 0..i (delta 0 is always 0). Both columns start at aligned offsets,
+ * so the file can be mmap'd and the columns used in place.
+ */
+typedef struct
+{
+    char magic[4];              // SERIES_MAGIC
+    uint16_t version;           // SERIES_VERSION
+    uint16_t header_size;       // sizeof(SeriesHeader)
+    uint32_t filter_type;       // FilterType used to produce the data
+    uint32_t value_encoding;    // ValueEncoding of the value column
+    uint64_t num_samples;       // Rows in each column
+    int64_t first_timestamp;    // Seconds since the epoch of row 0
+    float value_scale;          // Quantisation step for VALUE_INT16
+    float value_offset;         // Value of raw 0 for VALUE_INT16
+    uint32_t decimation;        // Decimation factor applied before writing (1 = none)
+    uint32_t reserved;          // Zero, keeps the column offsets 8-byte aligned
+    uint64_t timestamps_offset; // Byte offset of the timestamp column
+    uint64_t values_offset;     // Byte offset of the value column
+} SeriesHeader;
+
+// A binary series file mapped into memory
+typedef struct
+{
+    const SeriesHeader *header;
+    const int64_t *timestamp_deltas;
+    const void *values;
+    void *mapping;
+    size_t mapping_size;
+} SeriesFile;
+
+int write_series_binary(const char *filename, const float *data, const int64_t *timestamps, int num_samples,
+                        FilterType filter_type, int decimation, ValueEncoding encoding); // Write a binary series file
+int series_open(SeriesFile *series, const char *filename);                              // mmap and validate a file
+float series_value(const SeriesFile *series, size_t index);                             // Decoded value of row 'index'
+void series_close(SeriesFile *series);                                                  // Unmap the file
+int export_series_csv(const char *binary_filename, const char *csv_filename);           // Binary -> CSV (write_csv layout)
+
+#endif
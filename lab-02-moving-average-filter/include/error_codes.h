@@ -12,7 +12,11 @@ typedef enum
     TAPS_EXCEEDS_SAMPLES_ERROR,
     FILE_WRITE_ERROR,
     UNKNOWN_FILTER_TYPE,
-    INVALID_ARGUMENT
+    INVALID_ARGUMENT,
+    MEMORY_ALLOCATION_ERROR,
+    INVALID_TIMESTAMP,
+    BENCHMARK_REGRESSION,
+    THREAD_START_ERROR
 } ErrorCode;
 
 #endif
\ No newline at end of file
@@ -4,16 +4,25 @@
 #define MAX_SAMPLES 9000      // Maximum number of input samples
 #define TAPS 63               // Number of taps for the moving average filter
 #define LOW_FILTER_TAP_NUM 31 // Number of filter taps for a low-pass FIR filter
+#define DEFAULT_PERCENTILE 90 // Percentile used by the PERCENTILE filter unless given
 
 // Enumeration for different filter types
 typedef enum
 {
     MOVING_AVERAGE,
     LOW_PASS,
+    MEDIAN,     // Sliding-window median, rejects single-sample spikes
+    PERCENTILE, // Sliding-window percentile
 } FilterType;
 
 int apply_filter(float *input, float *output, int num_samples, FilterType filter_type);
+const char *filter_type_name(FilterType filter_type);
 int moving_average_filter(float *input, float *output, int num_samples, int taps);
 int low_pass_filter(float *input, float *output, int num_samples, int moving_average_taps);
+int median_filter(float *input, float *output, int num_samples, int taps);
+int percentile_filter(float *input, float *output, int num_samples, int taps, float percentile);
+
+// Coefficients of the low-pass FIR stage (defined in low_pass_filter.c)
+extern const float filter_taps[LOW_FILTER_TAP_NUM];
 
 #endif
\ No newline at end of file
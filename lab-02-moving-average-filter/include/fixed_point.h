@@ -0,0 +1,39 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+#include "filter.h"
+
+#define FIXED_FULL_SCALE 128.0f // Input value that maps to 1.0 in Q15/Q31 (temperatures in °C)
+#define MAX_FIXED_TAPS 65535    // Keeps the Q15 moving average sum inside 32 bits
+
+// Fixed-point sample formats
+typedef enum
+{
+    FIXED_NONE, // Plain float processing
+    FIXED_Q15,  // int16_t, 15 fractional bits
+    FIXED_Q31,  // int32_t, 31 fractional bits
+} FixedFormat;
+
+// Conversion between float samples and fixed-point (values beyond full_scale saturate)
+void quantize_q15(const float *input, int16_t *output, int num_samples, float full_scale);
+void dequantize_q15(const int16_t *input, float *output, int num_samples, float full_scale);
+void quantize_q31(const float *input, int32_t *output, int num_samples, float full_scale);
+void dequantize_q31(const int32_t *input, float *output, int num_samples, float full_scale);
+
+// Fixed-point kernels with saturating arithmetic
+int moving_average_filter_q15(const int16_t *input, int16_t *output, int num_samples, int taps);
+int moving_average_filter_q31(const int32_t *input, int32_t *output, int num_samples, int taps);
+int fir_filter_q15(const int16_t *input, int16_t *output, int num_samples, const int16_t *taps, int num_taps);
+int fir_filter_q31(const int32_t *input, int32_t *output, int num_samples, const int32_t *taps, int num_taps);
+int low_pass_filter_q15(const int16_t *input, int16_t *output, int num_samples, int moving_average_taps);
+int low_pass_filter_q31(const int32_t *input, int32_t *output, int num_samples, int moving_average_taps);
+
+// Quantised copies of filter_taps
+const int16_t *low_pass_taps_q15(void);
+const int32_t *low_pass_taps_q31(void);
+
+// Quantise, filter in fixed point and convert back, the fixed-point counterpart of apply_filter
+int apply_filter_fixed(const float *input, float *output, int num_samples, FilterType filter_type, FixedFormat format);
+
+#endif
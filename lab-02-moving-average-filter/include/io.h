@@ -1,7 +1,28 @@
 #ifndef IO_H
 #define IO_H
 
-int read_csv(const char *filename, float *data, char timestamps[MAX_SAMPLES][20], int *num_samples);
-int write_csv(const char *filename, float *data, char timestamps[MAX_SAMPLES][20], int num_samples, FilterType filter_type);
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "filter.h"
+
+#define CSV_LINE_LENGTH 128 // Longest accepted CSV line, including the newline
+
+// Row-by-row CSV reader for files that do not fit in the sample arrays
+typedef struct
+{
+    FILE *file;
+    long rows_read;     // Rows converted into samples
+    long rows_rejected; // Rows skipped because they could not be parsed
+} CsvReader;
+
+int csv_reader_open(CsvReader *reader, const char *filename);                // Open the file and skip the header
+bool csv_reader_next(CsvReader *reader, int64_t *timestamp, float *value);   // Read the next valid row
+void csv_reader_close(CsvReader *reader);                                    // Close the file
+
+int read_csv(const char *filename, float *data, int64_t *timestamps, int *num_samples);
+void write_csv_header(FILE *file);                                                       // Column names
+void write_csv_row(FILE *file, const char *filter_name, int64_t timestamp, float value); // One formatted row
+int write_csv(const char *filename, float *data, int64_t *timestamps, int num_samples, FilterType filter_type);
 
 #endif
\ No newline at end of file
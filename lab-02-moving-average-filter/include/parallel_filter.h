@@ -0,0 +1,26 @@
+#ifndef PARALLEL_FILTER_H
+#define PARALLEL_FILTER_H
+
+#include <stddef.h>
+#include "filter.h"
+
+#define PARALLEL_CHUNK_SIZE 65536 // Samples per work item
+#define MAX_FILTER_THREADS 256    // Upper bound for the worker count
+
+// Filter a long series on several threads.
+// The series is cut into chunks of PARALLEL_CHUNK_SIZE samples. Before a chunk
+// is filtered, the worker replays the samples just before it (the halo) into
+// a freshly reset filter, so the window is exactly what the serial filter would
+// see there and the output is bit-identical to the single-threaded result.
+// Chunks are dealt out to the workers in contiguous ranges; a worker that runs
+// out steals the upper half of another worker's remaining range.
+//
+// num_threads <= 0 uses one thread per online CPU. 'percentile' is only used
+// by the PERCENTILE filter.
+int parallel_filter(const float *input, float *output, size_t num_samples, FilterType filter_type, int taps,
+                    float percentile, int num_threads);
+
+// Samples before a chunk that influence its first output
+int filter_halo_length(FilterType filter_type, int taps);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "filter.h"
+
+#define PIPELINE_BLOCK_SIZE 4096 // Samples per block passed between the stages
+#define PIPELINE_NUM_BLOCKS 8    // Blocks in circulation (bounds the memory use)
+
+// Read -> filter -> write with one thread per stage.
+// Blocks of samples travel through lock-free single-producer/single-consumer
+// queues and are recycled from the writer back to the parser, so the stages
+// overlap and nothing is allocated after start-up. The output is identical to
+// read_csv + apply_filter + write_csv, but the input length is not limited by
+// MAX_SAMPLES.
+int run_pipeline(const char *input_filename, const char *output_filename, FilterType filter_type, float percentile);
+
+#endif
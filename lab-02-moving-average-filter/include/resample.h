@@ -0,0 +1,26 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#define RESAMPLE_TAPS_PER_RATIO 16 // Anti-aliasing FIR length per unit of max(L, M)
+#define MAX_RESAMPLE_FACTOR 1024   // Upper bound for the interpolation and decimation factors
+
+// Opaque handle to a polyphase rational resampler (L/M).
+// The input is conceptually upsampled by 'interpolation' (L), low-pass filtered
+// and downsampled by 'decimation' (M), but only the outputs that survive the
+// downsampling are ever computed, each one with a single polyphase branch.
+typedef struct Resampler Resampler;
+
+int resampler_create(Resampler **resampler, int interpolation, int decimation); // Design the filter and allocate the history
+int resampler_process(Resampler *resampler, const float *input, int num_input,
+                      float *output, int max_output, int *num_output);         // Push a block, collect the produced outputs
+int resampler_flush(Resampler *resampler, float *output, int max_output, int *num_output); // Produce the delayed tail at end of input
+int resampler_output_length(int num_input, int interpolation, int decimation);  // Number of outputs for 'num_input' samples
+void resampler_reset(Resampler *resampler);                                     // Clear the history
+void resampler_destroy(Resampler *resampler);                                   // Release the resampler
+
+int resample_filter(const float *input, int num_samples, float *output, int max_output,
+                    int interpolation, int decimation, int *num_output);         // Batch rational resampling
+int decimate_filter(const float *input, int num_samples, float *output, int max_output,
+                    int factor, int *num_output);                                // Batch anti-aliased decimation
+
+#endif
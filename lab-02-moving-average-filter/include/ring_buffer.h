@@ -0,0 +1,82 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdlib.h>
+#include "error_codes.h"
+
+// Ring buffer holding the most recent samples.
+// The capacity is rounded up to a power of two so that wrapping the index
+// is a single AND with 'mask' instead of a division.
+typedef struct
+{
+    float *data;   // Sample storage (capacity = mask + 1)
+    unsigned mask; // capacity - 1
+    unsigned head; // Index of the most recently written sample
+    int count;     // Number of valid samples, saturates at the window length
+} RingBuffer;
+
+// Smallest power of two that is greater than or equal to 'n'
+static inline unsigned next_power_of_two(unsigned n)
+{
+    unsigned capacity = 1;
+    while (capacity < n)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+static inline int ring_init(RingBuffer *ring, int length)
+{
+    unsigned capacity = next_power_of_two((unsigned)length);
+
+    // calloc so that FIR histories start out as zeros
+    ring->data = calloc(capacity, sizeof(float));
+    if (ring->data == NULL)
+    {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    ring->mask = capacity - 1;
+    ring->head = ring->mask; // First push lands on index 0
+    ring->count = 0;
+    return SUCCESS;
+}
+
+static inline void ring_clear(RingBuffer *ring)
+{
+    if (ring->data != NULL)
+    {
+        for (unsigned i = 0; i <= ring->mask; i++)
+        {
+            ring->data[i] = 0.0f;
+        }
+    }
+    ring->head = ring->mask;
+    ring->count = 0;
+}
+
+// Store a new sample, overwriting the oldest one once the window is full
+static inline void ring_push(RingBuffer *ring, float sample, int length)
+{
+    ring->head = (ring->head + 1) & ring->mask;
+    ring->data[ring->head] = sample;
+    if (ring->count < length)
+    {
+        ring->count++;
+    }
+}
+
+// Sample 'age' steps back in time (age 0 is the newest one)
+static inline float ring_get(const RingBuffer *ring, int age)
+{
+    return ring->data[(ring->head - (unsigned)age) & ring->mask];
+}
+
+static inline void ring_free(RingBuffer *ring)
+{
+    free(ring->data);
+    ring->data = NULL;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#define SKIPLIST_MAX_LEVEL 24 // Enough for windows of millions of samples
+
+// Sorted multiset of floats with O(log n) insert, remove and rank lookup.
+// Every link stores how many elements it skips ("width"), so the k-th
+// smallest value is found by walking down the levels like a binary search.
+// All nodes come from a pool allocated by skiplist_create(), so insert and
+// remove never allocate.
+typedef struct IndexableSkiplist IndexableSkiplist;
+
+int skiplist_create(IndexableSkiplist **list, int capacity);   // Pool for up to 'capacity' values
+int skiplist_insert(IndexableSkiplist *list, float value);     // Add a value
+int skiplist_remove(IndexableSkiplist *list, float value);     // Remove one occurrence of a value
+float skiplist_get(const IndexableSkiplist *list, int rank);   // k-th smallest value (rank 0 is the minimum)
+int skiplist_size(const IndexableSkiplist *list);              // Number of stored values
+void skiplist_clear(IndexableSkiplist *list);                  // Remove all values
+void skiplist_destroy(IndexableSkiplist *list);                // Release the list
+
+#endif
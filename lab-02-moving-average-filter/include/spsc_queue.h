@@ -0,0 +1,33 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE_SIZE 64
+
+// Bounded lock-free queue of pointers for exactly one producer thread and one
+// consumer thread. Each index is written by one side only, so plain
+// acquire/release atomics are enough; no locks or compare-and-swap needed.
+// The indices sit on separate cache lines so the two threads do not keep
+// stealing the same line from each other.
+typedef struct
+{
+    void **slots;
+    size_t mask;                                  // capacity - 1, capacity is a power of two
+    alignas(CACHE_LINE_SIZE) atomic_size_t head;  // Next slot to read, written by the consumer
+    alignas(CACHE_LINE_SIZE) atomic_size_t tail;  // Next slot to write, written by the producer
+} SpscQueue;
+
+int spsc_queue_init(SpscQueue *queue, size_t capacity);   // Capacity is rounded up to a power of two
+bool spsc_queue_push(SpscQueue *queue, void *item);       // Producer side, false if full
+bool spsc_queue_pop(SpscQueue *queue, void **item);       // Consumer side, false if empty
+void spsc_queue_push_wait(SpscQueue *queue, void *item);  // Push, waiting while the queue is full
+void *spsc_queue_pop_wait(SpscQueue *queue);              // Pop, waiting while the queue is empty
+void *spsc_queue_pop_until(SpscQueue *queue, atomic_bool *stop); // Same, but NULL once *stop is set
+size_t spsc_queue_size(SpscQueue *queue);                 // Approximate number of queued items
+void spsc_queue_destroy(SpscQueue *queue);
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+// Processing stages timed by the --stats report
+typedef enum
+{
+    STAGE_READ,        // Parsing the input CSV
+    STAGE_FILTER,      // Float filter
+    STAGE_FIXED_POINT, // Fixed-point comparison run (-q15/-q31)
+    STAGE_DECIMATE,    // Output rate reduction (-decimate)
+    STAGE_WRITE,       // Formatting and writing the output file
+    STAGE_AGGREGATE,   // Calendar aggregation (-agg), read and write included
+    STAGE_EXPORT,      // Binary to CSV conversion (-export)
+    STAGE_TOTAL,       // Whole run
+    NUM_STAGES,
+} StatsStage;
+
+// Timers and counters of one run of the program.
+// Every stage is timed by the one thread that runs it, and the threaded
+// modes only report after joining their threads, so no atomics are needed.
+// In the pipeline the stages overlap, so their times add up to more than
+// the total.
+typedef struct
+{
+    bool enabled;                   // Everything below stays untouched unless set
+    uint64_t stage_ns[NUM_STAGES];  // Time spent in each stage
+    long stage_calls[NUM_STAGES];   // How often each stage ran (once per block in the pipeline)
+    long rows_read;                 // Valid input rows
+    long rows_rejected;             // Input lines skipped as unparseable
+    uint64_t bytes_in;              // Bytes read from the input file
+    uint64_t bytes_out;             // Bytes written to the output file
+    long samples_filtered;          // Samples pushed through the filter
+    size_t peak_buffer_bytes;       // Largest amount of sample data held in memory at once
+} FilterStats;
+
+extern FilterStats filter_stats;
+
+// Monotonic clock in nanoseconds, not affected by changes to the wall clock
+static inline uint64_t stats_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// With the statistics disabled, each of these helpers is a single
+// predictable branch, so they can stay in the hot paths of the program.
+static inline uint64_t stats_start(void)
+{
+    return filter_stats.enabled ? stats_now_ns() : 0;
+}
+
+static inline void stats_stop(StatsStage stage, uint64_t start)
+{
+    if (filter_stats.enabled)
+    {
+        filter_stats.stage_ns[stage] += stats_now_ns() - start;
+        filter_stats.stage_calls[stage]++;
+    }
+}
+
+static inline void stats_add_rows(long rows_read, long rows_rejected)
+{
+    if (filter_stats.enabled)
+    {
+        filter_stats.rows_read += rows_read;
+        filter_stats.rows_rejected += rows_rejected;
+    }
+}
+
+static inline void stats_add_samples(long samples)
+{
+    if (filter_stats.enabled)
+    {
+        filter_stats.samples_filtered += samples;
+    }
+}
+
+static inline void stats_add_bytes(uint64_t bytes_in, uint64_t bytes_out)
+{
+    if (filter_stats.enabled)
+    {
+        filter_stats.bytes_in += bytes_in;
+        filter_stats.bytes_out += bytes_out;
+    }
+}
+
+static inline void stats_buffer_usage(size_t bytes)
+{
+    if (filter_stats.enabled && bytes > filter_stats.peak_buffer_bytes)
+    {
+        filter_stats.peak_buffer_bytes = bytes;
+    }
+}
+
+void stats_add_file_bytes(FILE *file, bool output); // Count the bytes up to the current position, call before fclose
+void stats_print_json(FILE *file);                  // Write the report
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef STREAM_FILTER_H
+#define STREAM_FILTER_H
+
+#include "filter.h"
+
+// Opaque handle to a stateful filter that consumes one sample at a time.
+// The history lives in power-of-two ring buffers (plus a node pool for the
+// median/percentile order statistics) allocated once by stream_filter_create(),
+// so pushing samples never allocates.
+typedef struct StreamFilter StreamFilter;
+
+int stream_filter_create(StreamFilter **filter, FilterType filter_type, int taps);             // Allocate a filter object
+int stream_filter_create_percentile(StreamFilter **filter, int taps, float percentile);        // Percentile filter (0-100)
+int stream_filter_push(StreamFilter *filter, float sample, float *output);                      // Feed one sample, get one output
+int stream_filter_push_block(StreamFilter *filter, const float *input, float *output, int num_samples); // Feed a block of samples
+void stream_filter_reset(StreamFilter *filter);                                                 // Clear the history, keep the configuration
+void stream_filter_destroy(StreamFilter *filter);                                               // Release the filter object
+
+#endif
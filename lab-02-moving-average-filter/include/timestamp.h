@@ -0,0 +1,17 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TIMESTAMP_LENGTH 20   // "YYYY-MM-DDTHH:MM:SS" + null terminator
+#define SECONDS_PER_DAY 86400
+
+// Timestamps are kept as seconds since 1970-01-01T00:00 in the time zone of the
+// data file. The CSV files carry no offset, so no time zone conversion is done.
+int parse_timestamp(const char *text, int64_t *epoch);                // "YYYY-MM-DDTHH:MM[:SS]" -> seconds
+void format_timestamp(int64_t epoch, char *buffer, size_t size);      // seconds -> "YYYY-MM-DDTHH:MM[:SS]"
+int64_t days_from_civil(int64_t year, unsigned month, unsigned day);  // Calendar date -> days since epoch
+void civil_from_days(int64_t days, int64_t *year, unsigned *month, unsigned *day); // Days since epoch -> calendar date
+
+#endif
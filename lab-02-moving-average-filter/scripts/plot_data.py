@@ -1,7 +1,59 @@
 import os
+import sys
+import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
 
+# Layout of the binary series header written by the filter program with -bin/-bin16
+# (see include/binary_io.h)
+SERIES_HEADER = np.dtype(
+    [
+        ("magic", "S4"),
+        ("version", "<u2"),
+        ("header_size", "<u2"),
+        ("filter_type", "<u4"),
+        ("value_encoding", "<u4"),
+        ("num_samples", "<u8"),
+        ("first_timestamp", "<i8"),
+        ("value_scale", "<f4"),
+        ("value_offset", "<f4"),
+        ("decimation", "<u4"),
+        ("reserved", "<u4"),
+        ("timestamps_offset", "<u8"),
+        ("values_offset", "<u8"),
+    ]
+)
+FILTER_NAMES = {0: "Moving Average", 1: "Low Pass", 2: "Median", 3: "Percentile"}
+
+
+def load_binary_series(path):
+    """Map a binary series file and build a DataFrame from its columns without any text parsing."""
+    raw = np.memmap(path, mode="r")
+    header = raw[: SERIES_HEADER.itemsize].view(SERIES_HEADER)[0]
+    if header["magic"] != b"FSER":
+        raise ValueError(f"{path} is not a binary series file")
+
+    count = int(header["num_samples"])
+    ts_start = int(header["timestamps_offset"])
+    deltas = raw[ts_start : ts_start + 8 * count].view("<i8")
+    timestamps = int(header["first_timestamp"]) + np.cumsum(deltas)
+
+    values_start = int(header["values_offset"])
+    if header["value_encoding"] == 1:  # int16, quantised
+        quantised = raw[values_start : values_start + 2 * count].view("<i2")
+        values = quantised * header["value_scale"] + header["value_offset"]
+    else:  # float32
+        values = raw[values_start : values_start + 4 * count].view("<f4")
+
+    return pd.DataFrame(
+        {
+            "FilterType": FILTER_NAMES.get(int(header["filter_type"]), "Unknown"),
+            "DateTime": pd.to_datetime(timestamps, unit="s"),
+            "Temperature (°C)": np.asarray(values, dtype=np.float32),
+        }
+    )
+
+
 # Construct paths for the CSV files
 data_file_path_original = os.path.join(
     os.path.dirname(os.path.abspath(__file__)), "../data/temperature_data.csv"
@@ -10,12 +62,26 @@ data_file_path_filtered = os.path.join(
     os.path.dirname(os.path.abspath(__file__)), "../data/filtered_data.csv"
 )
 
+# Optionally plot another filtered file, e.g. a binary one: plot_data.py ../data/filtered_data.bin
+if len(sys.argv) > 1:
+    data_file_path_filtered = sys.argv[1]
+
 # Load the data from CSV files into DataFrames
 df_original = pd.read_csv(data_file_path_original)
-df_filtered = pd.read_csv(data_file_path_filtered)
+if data_file_path_filtered.endswith(".bin"):
+    df_filtered = load_binary_series(data_file_path_filtered)
+else:
+    df_filtered = pd.read_csv(data_file_path_filtered)
 
-# Extract the filter type from the first row (assuming it is consistent across the file)
-filter_type = df_filtered["FilterType"].iloc[0]
+# A file written with '-agg day|week|month' holds per-period statistics computed
+# by the C program, so no resampling is needed here
+aggregated = "Aggregation" in df_filtered.columns
+if aggregated:
+    filter_type = df_filtered["Aggregation"].iloc[0]
+    df_filtered = df_filtered.rename(columns={"Mean": "Temperature (°C)"})
+else:
+    # Extract the filter type from the first row (assuming it is consistent across the file)
+    filter_type = df_filtered["FilterType"].iloc[0]
 
 # Convert the 'DateTime' column to datetime objects for both DataFrames
 df_original["DateTime"] = pd.to_datetime(df_original["DateTime"])
@@ -28,12 +94,13 @@ df_filtered.set_index("DateTime", inplace=True)
 
 # Limit data for both DataFrames to a reasonable number of points
 # .iloc[] allows integer-location based indexing to select rows and columns by index.
+# Plain striping aliases, so for the filtered series prefer running the filter
+# with '-decimate N', which reduces the rate with an anti-aliasing filter in C.
 df_original_limited = df_original.iloc[::20]  # Select every 20th point
-df_filtered_limited = df_filtered.iloc[::20]  # Select every 20th point
-
-# Resample to daily frequency and calculate the mean
-# df_original_daily = df_original.resample("D").mean()
-# df_filtered_daily = df_filtered.resample("D").mean()
+if len(df_filtered) < len(df_original):
+    df_filtered_limited = df_filtered  # Already decimated by the filter program
+else:
+    df_filtered_limited = df_filtered.iloc[::20]  # Select every 20th point
 
 # Plot the temperature data from both DataFrames
 plt.figure(figsize=(12, 6))  # Width: 12 inches, Height: 6 inches
@@ -42,8 +109,6 @@ plt.figure(figsize=(12, 6))  # Width: 12 inches, Height: 6 inches
 plt.plot(
     df_original_limited.index,
     df_original_limited["Temperature (°C)"],
-    # df_original_daily.index,
-    # df_original_daily["Temperature (°C)"],
     linestyle="-",
     color="b",
     label="Original Temperature (°C)",
@@ -53,15 +118,27 @@ plt.plot(
 plt.plot(
     df_filtered_limited.index,
     df_filtered_limited["Temperature (°C)"],
-    # df_filtered_daily.index,
-    # df_filtered_daily["Temperature (°C)"],
     linestyle="-",
     color="r",
     label="Filtered Temperature (°C)",
 )
 
+# Show the spread of each aggregation period around its mean
+if aggregated:
+    plt.fill_between(
+        df_filtered_limited.index,
+        df_filtered_limited["Min"],
+        df_filtered_limited["Max"],
+        color="r",
+        alpha=0.2,
+        label="Min/Max (°C)",
+    )
+
 # Add labels and title
-plt.title(f"Temperature Over Time (Original with {filter_type} Filter)")
+if aggregated:
+    plt.title(f"Temperature Over Time (Original with {filter_type} Mean)")
+else:
+    plt.title(f"Temperature Over Time (Original with {filter_type} Filter)")
 plt.ylabel("Temperature (°C)")
 plt.xticks(rotation=45)  # Rotate x-axis labels for better visibility
 plt.grid()
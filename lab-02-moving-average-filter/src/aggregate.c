@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <math.h>
+#include "aggregate.h"
+#include "timestamp.h"
+#include "error_codes.h"
+#include "io.h"
+#include "stats.h"
+
+int64_t bucket_start(int64_t timestamp, BucketSize bucket_size)
+{
+    // Floor division, so that times before 1970 land in the right day
+    int64_t days = timestamp / SECONDS_PER_DAY;
+    if (timestamp % SECONDS_PER_DAY < 0)
+    {
+        days--;
+    }
+
+    switch (bucket_size)
+    {
+    case BUCKET_WEEK:
+    {
+        // 1970-01-01 was a Thursday, so Monday-based weekday = (days + 3) mod 7
+        int64_t weekday = (days + 3) % 7;
+        if (weekday < 0)
+        {
+            weekday += 7;
+        }
+        days -= weekday;
+        break;
+    }
+
+    case BUCKET_MONTH:
+    {
+        int64_t year;
+        unsigned month, day;
+        civil_from_days(days, &year, &month, &day);
+        days = days_from_civil(year, month, 1);
+        break;
+    }
+
+    case BUCKET_DAY:
+    default:
+        break;
+    }
+
+    return days * SECONDS_PER_DAY;
+}
+
+void bucket_stats_init(BucketStats *stats, int64_t start)
+{
+    stats->start = start;
+    stats->count = 0;
+    stats->min = 0.0f;
+    stats->max = 0.0f;
+    stats->mean = 0.0;
+    stats->m2 = 0.0;
+}
+
+void bucket_stats_add(BucketStats *stats, float value)
+{
+    if (stats->count == 0 || value < stats->min)
+    {
+        stats->min = value;
+    }
+    if (stats->count == 0 || value > stats->max)
+    {
+        stats->max = value;
+    }
+
+    // Welford: update the mean with the new sample, then accumulate the
+    // product of the distances to the old and the new mean
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+double bucket_stats_stddev(const BucketStats *stats)
+{
+    return (stats->count > 1) ? sqrt(stats->m2 / (stats->count - 1)) : 0.0;
+}
+
+static const char *bucket_name(BucketSize bucket_size)
+{
+    switch (bucket_size)
+    {
+    case BUCKET_DAY:
+        return "Daily";
+    case BUCKET_WEEK:
+        return "Weekly";
+    case BUCKET_MONTH:
+        return "Monthly";
+    default:
+        return "Unknown";
+    }
+}
+
+static void write_bucket(FILE *file, const BucketStats *stats, BucketSize bucket_size)
+{
+    char timestamp[TIMESTAMP_LENGTH];
+    format_timestamp(stats->start, timestamp, sizeof(timestamp));
+    fprintf(file, "%s,%s,%ld,%.2f,%.2f,%.2f,%.2f\n", bucket_name(bucket_size), timestamp, stats->count,
+            stats->min, stats->max, stats->mean, bucket_stats_stddev(stats));
+}
+
+/*
+ * Function: aggregate_csv
+ * -----------------------------
+ * Reduces a time series to one row of statistics per day, week or month.
+ *
+ * The input is read row by row and only the statistics of the current bucket
+ * are kept in memory, so the size of the input file is not limited by
+ * MAX_SAMPLES or by the available memory. A bucket is written as soon as the
+ * first sample of the next one arrives, which requires the input to be sorted
+ * by time (as the fetched data is).
+ */
+int aggregate_csv(const char *input_filename, const char *output_filename, BucketSize bucket_size)
+{
+    CsvReader reader;
+    int result = csv_reader_open(&reader, input_filename);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    FILE *file = fopen(output_filename, "w");
+    if (file == NULL)
+    {
+        perror("Error opening file for writing");
+        csv_reader_close(&reader);
+        return FILE_WRITE_ERROR;
+    }
+
+    fprintf(file, "Aggregation,DateTime,Count,Min,Max,Mean,StdDev\n");
+
+    BucketStats stats;
+    int64_t timestamp;
+    float value;
+    bool have_bucket = false;
+
+    while (csv_reader_next(&reader, &timestamp, &value))
+    {
+        int64_t start = bucket_start(timestamp, bucket_size);
+
+        if (!have_bucket || start != stats.start)
+        {
+            if (have_bucket)
+            {
+                write_bucket(file, &stats, bucket_size); // Previous bucket is complete
+            }
+            bucket_stats_init(&stats, start);
+            have_bucket = true;
+        }
+
+        bucket_stats_add(&stats, value);
+    }
+
+    if (have_bucket)
+    {
+        write_bucket(file, &stats, bucket_size); // Last, possibly partial bucket
+    }
+
+    csv_reader_close(&reader);
+    stats_add_file_bytes(file, true);
+    if (fclose(file) != 0)
+    {
+        return FILE_WRITE_ERROR;
+    }
+
+    return have_bucket ? SUCCESS : FILE_HAS_NO_CONTENT;
+}
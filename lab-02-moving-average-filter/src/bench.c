@@ -0,0 +1,829 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include "filter.h"
+#include "parallel_filter.h"
+#include "pipeline.h"
+#include "timestamp.h"
+#include "io.h"
+#include "error_codes.h"
+
+// Build information, passed in by CMakeLists.txt
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE "unknown"
+#endif
+#ifndef BENCH_C_FLAGS
+#define BENCH_C_FLAGS ""
+#endif
+
+#define MAX_RESULTS 256    // Benchmarks in one run
+#define MAX_LIST_ITEMS 16  // Entries of --taps and --threads
+#define NAIVE_SAMPLES 2000 // The sorting median reference is far slower, so it gets fewer
+#define BASELINE_LINE_LENGTH 1024
+
+// Benchmark groups, selected with --groups
+#define GROUP_FILTER (1 << 0)     // Every FilterType and tap count
+#define GROUP_MEDIAN_REF (1 << 1) // Skiplist median against sorting the window
+#define GROUP_PARALLEL (1 << 2)   // Partitioned filter per thread count
+#define GROUP_IO (1 << 3)         // read_csv, write_csv and the streaming reader
+#define GROUP_END_TO_END (1 << 4) // Read, filter and write a file
+#define GROUP_ALL 0x1F
+
+typedef struct
+{
+    long samples;                  // Length of the synthetic signal
+    int taps[MAX_LIST_ITEMS];      // Window sizes for the filter group
+    int num_taps;
+    int threads[MAX_LIST_ITEMS];   // Thread counts for the parallel group
+    int num_threads;
+    int warmup;                    // Untimed runs before the measurement
+    int reps;                      // Timed runs, the median is reported
+    unsigned groups;
+    const char *output_filename;   // JSON destination, stdout if NULL
+    const char *baseline_filename; // Earlier JSON output to compare against
+    double threshold;              // Slowdown in percent reported as a regression
+    const char *work_dir;          // Where the temporary CSV files go
+} BenchConfig;
+
+typedef struct
+{
+    char name[64];
+    const char *group;
+    long samples;       // Samples processed per run
+    double bytes;       // Bytes processed per run
+    double min_ns;      // Fastest run
+    double median_ns;
+    int match;          // Output check: 1 passed, 0 failed, -1 not applicable
+    double baseline_ns; // ns/sample of the same benchmark in the baseline, 0 if none
+} BenchResult;
+
+typedef enum
+{
+    RUN_FILTER,
+    RUN_MEDIAN_SORT,
+    RUN_PARALLEL,
+    RUN_READ_CSV,
+    RUN_WRITE_CSV,
+    RUN_CSV_READER,
+    RUN_END_TO_END,
+    RUN_PIPELINE,
+} RunKind;
+
+// Everything a benchmark run may need; each kind uses a subset
+typedef struct
+{
+    RunKind kind;
+    FilterType filter_type;
+    int taps;
+    int threads;
+    const float *input;
+    float *output;
+    long samples;
+    int64_t *timestamps;
+    float *scratch;
+    const char *input_filename;
+    const char *output_filename;
+} BenchRun;
+
+static BenchResult results[MAX_RESULTS];
+static int num_results = 0;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Temperature-like test signal: daily cycle, noise and occasional spikes
+static void generate_signal(float *signal, long num_samples)
+{
+    unsigned state = 12345;
+    for (long i = 0; i < num_samples; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        float noise = ((state >> 16) & 0x7FFF) / 32768.0f - 0.5f;
+        signal[i] = 10.0f + 8.0f * sinf(i * 2.0f * 3.14159265f / 24.0f) + noise;
+        if ((state >> 8) % 500 == 0)
+        {
+            signal[i] += 40.0f; // Single-sample spike
+        }
+    }
+}
+
+// Write the signal as an hourly input CSV file, returns the file size or -1
+static long write_input_csv(const char *filename, const float *signal, long num_samples)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+    {
+        perror("Error opening file for writing");
+        return -1;
+    }
+
+    fprintf(file, "DateTime,Temperature (°C)\n");
+    int64_t start = days_from_civil(2020, 1, 1) * SECONDS_PER_DAY;
+    char text[TIMESTAMP_LENGTH];
+    for (long i = 0; i < num_samples; i++)
+    {
+        format_timestamp(start + i * 3600, text, sizeof(text));
+        fprintf(file, "%s,%.1f\n", text, signal[i]);
+    }
+
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static long file_size(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static int compare_floats(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Reference median: copy and sort the window for every sample, O(w log w).
+// Computes outputs first..first+num_samples-1 so that the window can be full.
+static void naive_median(const float *input, float *output, long first, long num_samples, int taps, float *scratch)
+{
+    for (long i = first; i < first + num_samples; i++)
+    {
+        long count = (i + 1 < taps) ? i + 1 : taps;
+        memcpy(scratch, input + i + 1 - count, (size_t)count * sizeof(float));
+        qsort(scratch, (size_t)count, sizeof(float), compare_floats);
+        output[i - first] = (count % 2) ? scratch[count / 2] : (scratch[count / 2 - 1] + scratch[count / 2]) / 2.0f;
+    }
+}
+
+// The batch filter for a given window size
+static int run_filter(FilterType filter_type, float *input, float *output, int num_samples, int taps)
+{
+    switch (filter_type)
+    {
+    case MOVING_AVERAGE:
+        return moving_average_filter(input, output, num_samples, taps);
+    case LOW_PASS:
+        return low_pass_filter(input, output, num_samples, taps);
+    case MEDIAN:
+        return median_filter(input, output, num_samples, taps);
+    case PERCENTILE:
+        return percentile_filter(input, output, num_samples, taps, DEFAULT_PERCENTILE);
+    default:
+        return UNKNOWN_FILTER_TYPE;
+    }
+}
+
+// Read, filter and write a file the way the filter program does
+static int run_end_to_end(const BenchRun *run)
+{
+    int num_samples = 0;
+    int result = read_csv(run->input_filename, run->scratch, run->timestamps, &num_samples);
+    if (result == SUCCESS)
+    {
+        result = run_filter(run->filter_type, run->scratch, run->output, num_samples, run->taps);
+    }
+    if (result == SUCCESS)
+    {
+        result = write_csv(run->output_filename, run->output, run->timestamps, num_samples, run->filter_type);
+    }
+    return result;
+}
+
+// Read every row with the streaming reader and discard it
+static int run_csv_reader(const char *filename)
+{
+    CsvReader reader;
+    int result = csv_reader_open(&reader, filename);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    int64_t timestamp;
+    float value;
+    while (csv_reader_next(&reader, &timestamp, &value))
+    {
+    }
+
+    csv_reader_close(&reader);
+    return SUCCESS;
+}
+
+static int execute(const BenchRun *run)
+{
+    int num_samples = 0;
+
+    switch (run->kind)
+    {
+    case RUN_FILTER:
+        return run_filter(run->filter_type, (float *)run->input, run->output, (int)run->samples, run->taps);
+    case RUN_MEDIAN_SORT:
+        naive_median(run->input, run->output, run->taps, run->samples, run->taps, run->scratch);
+        return SUCCESS;
+    case RUN_PARALLEL:
+        return parallel_filter(run->input, run->output, (size_t)run->samples, run->filter_type, run->taps,
+                               DEFAULT_PERCENTILE, run->threads);
+    case RUN_READ_CSV:
+        return read_csv(run->input_filename, run->output, run->timestamps, &num_samples);
+    case RUN_WRITE_CSV:
+        return write_csv(run->output_filename, (float *)run->input, run->timestamps, (int)run->samples,
+                         run->filter_type);
+    case RUN_CSV_READER:
+        return run_csv_reader(run->input_filename);
+    case RUN_END_TO_END:
+        return run_end_to_end(run);
+    case RUN_PIPELINE:
+        return run_pipeline(run->input_filename, run->output_filename, run->filter_type, DEFAULT_PERCENTILE);
+    }
+
+    return INVALID_ARGUMENT;
+}
+
+// Run a benchmark 'warmup' times untimed and 'reps' times timed, and record
+// the fastest and the median run. Returns the new result, or NULL on error.
+static BenchResult *measure(const BenchConfig *config, const char *group, const char *name, const BenchRun *run,
+                            double bytes)
+{
+    if (num_results == MAX_RESULTS)
+    {
+        fprintf(stderr, "Error: Too many benchmarks (limit %d).\n", MAX_RESULTS);
+        return NULL;
+    }
+
+    for (int i = 0; i < config->warmup; i++)
+    {
+        if (execute(run) != SUCCESS)
+        {
+            return NULL;
+        }
+    }
+
+    double *times = malloc((size_t)config->reps * sizeof(double));
+    if (times == NULL)
+    {
+        return NULL;
+    }
+
+    for (int i = 0; i < config->reps; i++)
+    {
+        double start = now_seconds();
+        int result = execute(run);
+        times[i] = (now_seconds() - start) * 1e9;
+        if (result != SUCCESS)
+        {
+            free(times);
+            return NULL;
+        }
+    }
+
+    qsort(times, (size_t)config->reps, sizeof(double), compare_doubles);
+
+    BenchResult *entry = &results[num_results++];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    entry->group = group;
+    entry->samples = run->samples;
+    entry->bytes = bytes;
+    entry->min_ns = times[0];
+    entry->median_ns = (config->reps % 2) ? times[config->reps / 2]
+                                          : (times[config->reps / 2 - 1] + times[config->reps / 2]) / 2.0;
+    entry->match = -1;
+    free(times);
+
+    fprintf(stderr, "%-32s %10.2f ns/sample\n", entry->name, entry->median_ns / entry->samples);
+    return entry;
+}
+
+// Short names used in the benchmark names
+static const char *filter_key(FilterType filter_type)
+{
+    static const char *keys[] = {"ma", "low", "median", "pct"};
+    return keys[filter_type];
+}
+
+static int bench_filters(const BenchConfig *config, const float *signal, float *output)
+{
+    for (int f = MOVING_AVERAGE; f <= PERCENTILE; f++)
+    {
+        for (int t = 0; t < config->num_taps; t++)
+        {
+            BenchRun run = {.kind = RUN_FILTER, .filter_type = (FilterType)f, .taps = config->taps[t],
+                            .input = signal, .output = output, .samples = config->samples};
+            char name[64];
+            snprintf(name, sizeof(name), "filter/%s/taps=%d", filter_key((FilterType)f), config->taps[t]);
+
+            // Each sample is read once and one output written
+            if (measure(config, "filter", name, &run, 2.0 * sizeof(float) * config->samples) == NULL)
+            {
+                return INVALID_ARGUMENT;
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+static int bench_median_reference(const BenchConfig *config, const float *signal, float *output, float *scratch,
+                                  float *reference)
+{
+    for (int t = 0; t < config->num_taps; t++)
+    {
+        int taps = config->taps[t];
+        long samples = (config->samples - taps < NAIVE_SAMPLES) ? config->samples - taps : NAIVE_SAMPLES;
+        if (samples <= 0)
+        {
+            continue;
+        }
+
+        BenchRun run = {.kind = RUN_MEDIAN_SORT, .taps = taps, .input = signal, .output = reference,
+                        .samples = samples, .scratch = scratch};
+        char name[64];
+        snprintf(name, sizeof(name), "median_sort/taps=%d", taps);
+
+        BenchResult *entry = measure(config, "median_reference", name, &run, 2.0 * sizeof(float) * samples);
+        if (entry == NULL)
+        {
+            return INVALID_ARGUMENT;
+        }
+
+        // The skiplist median must agree with the sorted windows
+        if (median_filter((float *)signal, output, (int)config->samples, taps) != SUCCESS)
+        {
+            return INVALID_ARGUMENT;
+        }
+        entry->match = memcmp(output + taps, reference, (size_t)samples * sizeof(float)) == 0;
+    }
+    return SUCCESS;
+}
+
+static int bench_parallel(const BenchConfig *config, const float *signal, float *output, float *serial)
+{
+    FilterType types[] = {MOVING_AVERAGE, LOW_PASS};
+    for (int f = 0; f < 2; f++)
+    {
+        if (run_filter(types[f], (float *)signal, serial, (int)config->samples, TAPS) != SUCCESS)
+        {
+            return INVALID_ARGUMENT;
+        }
+
+        for (int t = 0; t < config->num_threads; t++)
+        {
+            BenchRun run = {.kind = RUN_PARALLEL, .filter_type = types[f], .taps = TAPS,
+                            .threads = config->threads[t], .input = signal, .output = output,
+                            .samples = config->samples};
+            char name[64];
+            snprintf(name, sizeof(name), "parallel/%s/threads=%d", filter_key(types[f]), config->threads[t]);
+
+            BenchResult *entry = measure(config, "parallel", name, &run, 2.0 * sizeof(float) * config->samples);
+            if (entry == NULL)
+            {
+                return INVALID_ARGUMENT;
+            }
+
+            // Must be bit-identical to the serial filter
+            entry->match = memcmp(serial, output, (size_t)config->samples * sizeof(float)) == 0;
+        }
+    }
+    return SUCCESS;
+}
+
+// read_csv and write_csv hold at most MAX_SAMPLES rows; the streaming reader
+// and the pipeline get the full signal length
+static int bench_files(const BenchConfig *config, const float *signal, float *output, float *scratch,
+                       int64_t *timestamps)
+{
+    char small_input[512], large_input[512], output_file[512];
+    snprintf(small_input, sizeof(small_input), "%s/bench_input_small.csv", config->work_dir);
+    snprintf(large_input, sizeof(large_input), "%s/bench_input.csv", config->work_dir);
+    snprintf(output_file, sizeof(output_file), "%s/bench_output.csv", config->work_dir);
+
+    long small_samples = (config->samples < MAX_SAMPLES) ? config->samples : MAX_SAMPLES;
+    long small_size = write_input_csv(small_input, signal, small_samples);
+    long large_size = write_input_csv(large_input, signal, config->samples);
+    if (small_size < 0 || large_size < 0)
+    {
+        return FILE_WRITE_ERROR;
+    }
+
+    int result = SUCCESS;
+    char name[64];
+
+    if (config->groups & GROUP_IO)
+    {
+        BenchRun read = {.kind = RUN_READ_CSV, .output = output, .timestamps = timestamps, .samples = small_samples,
+                         .input_filename = small_input};
+        if (measure(config, "io", "io/read_csv", &read, small_size) == NULL)
+        {
+            result = FILE_NOT_FOUND;
+        }
+
+        // Writes back the rows that read_csv just parsed
+        BenchRun write = {.kind = RUN_WRITE_CSV, .filter_type = MOVING_AVERAGE, .input = output,
+                          .timestamps = timestamps, .samples = small_samples, .output_filename = output_file};
+        BenchResult *entry = (result == SUCCESS) ? measure(config, "io", "io/write_csv", &write, 0) : NULL;
+        if (entry == NULL)
+        {
+            result = FILE_WRITE_ERROR;
+        }
+        else
+        {
+            entry->bytes = file_size(output_file);
+        }
+
+        BenchRun stream = {.kind = RUN_CSV_READER, .samples = config->samples, .input_filename = large_input};
+        if (result == SUCCESS && measure(config, "io", "io/csv_reader", &stream, large_size) == NULL)
+        {
+            result = FILE_NOT_FOUND;
+        }
+    }
+
+    if (result == SUCCESS && (config->groups & GROUP_END_TO_END))
+    {
+        for (int f = MOVING_AVERAGE; f <= PERCENTILE && result == SUCCESS; f++)
+        {
+            BenchRun run = {.kind = RUN_END_TO_END, .filter_type = (FilterType)f, .taps = TAPS, .output = output,
+                            .timestamps = timestamps, .scratch = scratch, .samples = small_samples,
+                            .input_filename = small_input, .output_filename = output_file};
+            snprintf(name, sizeof(name), "end_to_end/%s", filter_key((FilterType)f));
+            if (measure(config, "end_to_end", name, &run, small_size) == NULL)
+            {
+                result = INVALID_ARGUMENT;
+            }
+        }
+
+        for (int f = MOVING_AVERAGE; f <= PERCENTILE && result == SUCCESS; f++)
+        {
+            BenchRun run = {.kind = RUN_PIPELINE, .filter_type = (FilterType)f, .samples = config->samples,
+                            .input_filename = large_input, .output_filename = output_file};
+            snprintf(name, sizeof(name), "pipeline/%s", filter_key((FilterType)f));
+            if (measure(config, "end_to_end", name, &run, large_size) == NULL)
+            {
+                result = INVALID_ARGUMENT;
+            }
+        }
+    }
+
+    remove(small_input);
+    remove(large_input);
+    remove(output_file);
+    return result;
+}
+
+// Look up the time per sample of every benchmark in an earlier JSON output,
+// so that runs with different --samples can still be compared.
+// Only the layout written by write_json is understood: one result per line.
+static int load_baseline(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror("Error opening baseline file");
+        return FILE_NOT_FOUND;
+    }
+
+    char line[BASELINE_LINE_LENGTH];
+    int found = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *name = strstr(line, "\"name\": \"");
+        char *per_sample = strstr(line, "\"ns_per_sample\": ");
+        if (name == NULL || per_sample == NULL)
+        {
+            continue;
+        }
+
+        name += strlen("\"name\": \"");
+        char *end = strchr(name, '"');
+        if (end == NULL)
+        {
+            continue;
+        }
+        *end = '\0';
+
+        double baseline_ns = strtod(per_sample + strlen("\"ns_per_sample\": "), NULL);
+        for (int i = 0; i < num_results; i++)
+        {
+            if (strcmp(results[i].name, name) == 0)
+            {
+                results[i].baseline_ns = baseline_ns;
+                found++;
+            }
+        }
+    }
+
+    fclose(file);
+    fprintf(stderr, "Baseline: %d of %d benchmarks found in %s\n", found, num_results, filename);
+    return SUCCESS;
+}
+
+// Returns the number of regressions against the baseline
+static int write_json(FILE *file, const BenchConfig *config)
+{
+    int regressions = 0;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"build_type\": \"%s\",\n", BENCH_BUILD_TYPE);
+    fprintf(file, "  \"c_flags\": \"%s\",\n", BENCH_C_FLAGS);
+    fprintf(file, "  \"samples\": %ld,\n", config->samples);
+    fprintf(file, "  \"warmup\": %d,\n", config->warmup);
+    fprintf(file, "  \"reps\": %d,\n", config->reps);
+    fprintf(file, "  \"results\": [\n");
+
+    for (int i = 0; i < num_results; i++)
+    {
+        const BenchResult *r = &results[i];
+        double seconds = r->median_ns * 1e-9;
+
+        fprintf(file,
+                "    {\"name\": \"%s\", \"group\": \"%s\", \"samples\": %ld, \"min_ns\": %.0f, \"median_ns\": %.0f, "
+                "\"ns_per_sample\": %.3f, \"samples_per_sec\": %.0f, \"bytes_per_sec\": %.0f",
+                r->name, r->group, r->samples, r->min_ns, r->median_ns, r->median_ns / r->samples,
+                r->samples / seconds, r->bytes / seconds);
+
+        if (r->match >= 0)
+        {
+            fprintf(file, ", \"match\": %s", r->match ? "true" : "false");
+        }
+
+        // A positive change means slower than the baseline
+        if (r->baseline_ns > 0.0)
+        {
+            double change = (r->median_ns / r->samples / r->baseline_ns - 1.0) * 100.0;
+            bool regression = change > config->threshold;
+            regressions += regression;
+            fprintf(file, ", \"baseline_ns_per_sample\": %.3f, \"change_percent\": %.1f, \"regression\": %s",
+                    r->baseline_ns, change, regression ? "true" : "false");
+        }
+
+        fprintf(file, "}%s\n", (i + 1 < num_results) ? "," : "");
+    }
+
+    fprintf(file, "  ]");
+    if (config->baseline_filename != NULL)
+    {
+        fprintf(file, ",\n  \"threshold_percent\": %.1f,\n  \"regressions\": %d", config->threshold, regressions);
+        fprintf(stderr, "%d regression(s) above %.1f%%\n", regressions, config->threshold);
+    }
+    fprintf(file, "\n}\n");
+    return regressions;
+}
+
+// Comma-separated list of positive integers, e.g. "15,63,255"
+static int parse_list(const char *text, int *values, int *count)
+{
+    *count = 0;
+    while (*text != '\0')
+    {
+        char *end;
+        long value = strtol(text, &end, 10);
+        if (end == text || value <= 0 || value > INT32_MAX || *count == MAX_LIST_ITEMS ||
+            (*end != ',' && *end != '\0'))
+        {
+            return INVALID_ARGUMENT;
+        }
+
+        values[(*count)++] = (int)value;
+        text = (*end == ',') ? end + 1 : end;
+    }
+
+    return (*count > 0) ? SUCCESS : INVALID_ARGUMENT;
+}
+
+static int parse_groups(const char *text, unsigned *groups)
+{
+    static const struct
+    {
+        const char *name;
+        unsigned flag;
+    } names[] = {
+        {"filter", GROUP_FILTER}, {"median_reference", GROUP_MEDIAN_REF}, {"parallel", GROUP_PARALLEL},
+        {"io", GROUP_IO},         {"end_to_end", GROUP_END_TO_END},      {"all", GROUP_ALL},
+    };
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+
+    *groups = 0;
+    for (char *name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ","))
+    {
+        bool known = false;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+            if (strcmp(name, names[i].name) == 0)
+            {
+                *groups |= names[i].flag;
+                known = true;
+            }
+        }
+
+        if (!known)
+        {
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    return (*groups != 0) ? SUCCESS : INVALID_ARGUMENT;
+}
+
+static void print_usage(void)
+{
+    fprintf(stderr, "Usage: filter_bench [options]\n"
+                    "  --samples N      Length of the synthetic signal (default 262144)\n"
+                    "  --taps LIST      Window sizes, e.g. 15,63,255 (default)\n"
+                    "  --threads LIST   Thread counts for the parallel filter (default 1,2,4)\n"
+                    "  --warmup N       Untimed runs before measuring (default 1)\n"
+                    "  --reps N         Timed runs, the median is reported (default 5)\n"
+                    "  --groups LIST    filter,median_reference,parallel,io,end_to_end or all (default)\n"
+                    "  --output FILE    Write the JSON results to FILE instead of stdout\n"
+                    "  --baseline FILE  Compare with an earlier JSON output\n"
+                    "  --threshold PCT  Slowdown reported as a regression (default 10)\n"
+                    "  --dir DIR        Directory for the temporary CSV files (default .)\n");
+}
+
+// Benchmark suite: every filter type and tap count, the CSV reader and writer,
+// and complete runs, reported as JSON. Progress goes to stderr.
+int main(int argc, char *argv[])
+{
+    BenchConfig config = {
+        .samples = 1 << 18,
+        .taps = {15, TAPS, 255},
+        .num_taps = 3,
+        .threads = {1, 2, 4},
+        .num_threads = 3,
+        .warmup = 1,
+        .reps = 5,
+        .groups = GROUP_ALL,
+        .threshold = 10.0,
+        .work_dir = ".",
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        int result = SUCCESS;
+
+        if (strcmp(argv[i], "--samples") == 0 && has_value)
+        {
+            config.samples = atol(argv[++i]);
+            result = (config.samples > 0 && config.samples <= INT32_MAX) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--taps") == 0 && has_value)
+        {
+            result = parse_list(argv[++i], config.taps, &config.num_taps);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            result = parse_list(argv[++i], config.threads, &config.num_threads);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && has_value)
+        {
+            config.warmup = atoi(argv[++i]);
+            result = (config.warmup >= 0) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && has_value)
+        {
+            config.reps = atoi(argv[++i]);
+            result = (config.reps > 0) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--groups") == 0 && has_value)
+        {
+            result = parse_groups(argv[++i], &config.groups);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && has_value)
+        {
+            config.output_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && has_value)
+        {
+            config.baseline_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && has_value)
+        {
+            config.threshold = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--dir") == 0 && has_value)
+        {
+            config.work_dir = argv[++i];
+        }
+        else
+        {
+            result = INVALID_ARGUMENT;
+        }
+
+        if (result != SUCCESS)
+        {
+            print_usage();
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    // Every window must fit in the signal
+    for (int t = 0; t < config.num_taps; t++)
+    {
+        if (config.taps[t] > config.samples || TAPS > config.samples)
+        {
+            fprintf(stderr, "Error: Number of taps (%d) cannot exceed number of samples (%ld).\n", config.taps[t],
+                    config.samples);
+            return TAPS_EXCEEDS_SAMPLES_ERROR;
+        }
+    }
+
+    size_t buffer_size = (size_t)config.samples * sizeof(float);
+    size_t scratch_size = (buffer_size > MAX_SAMPLES * sizeof(float)) ? buffer_size : MAX_SAMPLES * sizeof(float);
+    float *signal = malloc(buffer_size);
+    float *output = malloc(scratch_size);
+    float *serial = malloc(buffer_size);
+    float *scratch = malloc(scratch_size);
+    int64_t *timestamps = malloc(MAX_SAMPLES * sizeof(int64_t));
+    if (signal == NULL || output == NULL || serial == NULL || scratch == NULL || timestamps == NULL)
+    {
+        fprintf(stderr, "Error: Failed to allocate benchmark buffers.\n");
+        free(signal);
+        free(output);
+        free(serial);
+        free(scratch);
+        free(timestamps);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    generate_signal(signal, config.samples);
+
+    int result = SUCCESS;
+    if (config.groups & GROUP_FILTER)
+    {
+        result = bench_filters(&config, signal, output);
+    }
+    if (result == SUCCESS && (config.groups & GROUP_MEDIAN_REF))
+    {
+        result = bench_median_reference(&config, signal, output, scratch, serial);
+    }
+    if (result == SUCCESS && (config.groups & GROUP_PARALLEL))
+    {
+        result = bench_parallel(&config, signal, output, serial);
+    }
+    if (result == SUCCESS && (config.groups & (GROUP_IO | GROUP_END_TO_END)))
+    {
+        result = bench_files(&config, signal, output, scratch, timestamps);
+    }
+    if (result == SUCCESS && config.baseline_filename != NULL)
+    {
+        result = load_baseline(config.baseline_filename);
+    }
+
+    free(signal);
+    free(output);
+    free(serial);
+    free(scratch);
+    free(timestamps);
+
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Benchmark failed (Error code: %d)\n", result);
+        return result;
+    }
+
+    FILE *file = stdout;
+    if (config.output_filename != NULL)
+    {
+        file = fopen(config.output_filename, "w");
+        if (file == NULL)
+        {
+            perror("Error opening file for writing");
+            return FILE_WRITE_ERROR;
+        }
+    }
+
+    int regressions = write_json(file, &config);
+
+    if (file != stdout)
+    {
+        fclose(file);
+        fprintf(stderr, "Results saved to %s\n", config.output_filename);
+    }
+
+    // A regression fails the run, so that bench_compare can gate a build
+    return (regressions > 0) ? BENCHMARK_REGRESSION : SUCCESS;
+}
@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binary_io.h"
+#include "io.h"
+#include "stats.h"
+#include "error_codes.h"
+
+// The reader uses the header in place, so its layout must not depend on the compiler
+_Static_assert(sizeof(SeriesHeader) == 64, "SeriesHeader must be 64 bytes");
+
+// Choose scale and offset so that [min, max] maps onto the full int16 range
+static void quantisation_range(const float *data, int num_samples, float *scale, float *offset)
+{
+    float min = data[0];
+    float max = data[0];
+    for (int i = 1; i < num_samples; i++)
+    {
+        if (data[i] < min)
+        {
+            min = data[i];
+        }
+        if (data[i] > max)
+        {
+            max = data[i];
+        }
+    }
+
+    *offset = (min + max) / 2.0f;
+    *scale = (max > min) ? (max - min) / 65534.0f : 1.0f;
+}
+
+int write_series_binary(const char *filename, const float *data, const int64_t *timestamps, int num_samples,
+                        FilterType filter_type, int decimation, ValueEncoding encoding)
+{
+    if (filename == NULL || data == NULL || timestamps == NULL)
+    {
+        fprintf(stderr, "Error: Input or output array is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_samples <= 0)
+    {
+        fprintf(stderr, "Error: Number of samples must be greater than 0.\n");
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    SeriesHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SERIES_MAGIC, sizeof(header.magic));
+    header.version = SERIES_VERSION;
+    header.header_size = sizeof(SeriesHeader);
+    header.filter_type = (uint32_t)filter_type;
+    header.value_encoding = (uint32_t)encoding;
+    header.num_samples = (uint64_t)num_samples;
+    header.first_timestamp = timestamps[0];
+    header.value_scale = 1.0f;
+    header.value_offset = 0.0f;
+    header.decimation = (uint32_t)decimation;
+    header.timestamps_offset = sizeof(SeriesHeader);
+    header.values_offset = header.timestamps_offset + (uint64_t)num_samples * sizeof(int64_t);
+
+    if (encoding == VALUE_INT16)
+    {
+        quantisation_range(data, num_samples, &header.value_scale, &header.value_offset);
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+    {
+        perror("Error opening file for writing");
+        return FILE_WRITE_ERROR;
+    }
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Columns are encoded in small chunks so that no second copy of the series is needed
+    enum
+    {
+        CHUNK = 1024
+    };
+    int64_t deltas[CHUNK];
+    int16_t quantised[CHUNK];
+
+    for (int start = 0; ok && start < num_samples; start += CHUNK)
+    {
+        int count = (num_samples - start < CHUNK) ? num_samples - start : CHUNK;
+        for (int i = 0; i < count; i++)
+        {
+            int index = start + i;
+            deltas[i] = (index == 0) ? 0 : timestamps[index] - timestamps[index - 1];
+        }
+        ok = fwrite(deltas, sizeof(int64_t), (size_t)count, file) == (size_t)count;
+    }
+
+    for (int start = 0; ok && start < num_samples; start += CHUNK)
+    {
+        int count = (num_samples - start < CHUNK) ? num_samples - start : CHUNK;
+        if (encoding == VALUE_INT16)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                quantised[i] = (int16_t)lrintf((data[start + i] - header.value_offset) / header.value_scale);
+            }
+            ok = fwrite(quantised, sizeof(int16_t), (size_t)count, file) == (size_t)count;
+        }
+        else
+        {
+            ok = fwrite(data + start, sizeof(float), (size_t)count, file) == (size_t)count;
+        }
+    }
+
+    stats_add_file_bytes(file, true);
+    if (fclose(file) != 0 || !ok)
+    {
+        fprintf(stderr, "Error: Failed to write binary series to %s.\n", filename);
+        return FILE_WRITE_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+// Whether a column of count items starts and ends inside the mapping. Divides
+// instead of multiplying, so a crafted count cannot wrap the end around.
+static bool column_fits(uint64_t offset, uint64_t count, size_t item_size, size_t mapping_size)
+{
+    return offset <= mapping_size && count <= (mapping_size - offset) / item_size;
+}
+
+int series_open(SeriesFile *series, const char *filename)
+{
+    if (series == NULL || filename == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    memset(series, 0, sizeof(*series));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("Error opening file for reading");
+        return FILE_NOT_FOUND;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SeriesHeader))
+    {
+        close(fd);
+        return FILE_HAS_NO_CONTENT;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        perror("Error mapping file");
+        return FILE_NOT_FOUND;
+    }
+
+    series->mapping = mapping;
+    series->mapping_size = (size_t)info.st_size;
+    series->header = mapping;
+
+    // Check that the header is ours and that both columns fit in the file
+    const SeriesHeader *header = series->header;
+    size_t value_size = (header->value_encoding == VALUE_INT16) ? sizeof(int16_t) : sizeof(float);
+    if (memcmp(header->magic, SERIES_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SERIES_VERSION || header->header_size != sizeof(SeriesHeader) ||
+        header->value_encoding > VALUE_INT16 || header->num_samples == 0 ||
+        header->timestamps_offset % sizeof(int64_t) != 0 ||
+        !column_fits(header->timestamps_offset, header->num_samples, sizeof(int64_t), series->mapping_size) ||
+        header->values_offset % value_size != 0 ||
+        !column_fits(header->values_offset, header->num_samples, value_size, series->mapping_size))
+    {
+        fprintf(stderr, "Error: %s is not a valid binary series file.\n", filename);
+        series_close(series);
+        return FILE_HAS_NO_CONTENT;
+    }
+
+    series->timestamp_deltas = (const int64_t *)((const char *)mapping + header->timestamps_offset);
+    series->values = (const char *)mapping + header->values_offset;
+    return SUCCESS;
+}
+
+float series_value(const SeriesFile *series, size_t index)
+{
+    if (series->header->value_encoding == VALUE_INT16)
+    {
+        const int16_t *raw = series->values;
+        return raw[index] * series->header->value_scale + series->header->value_offset;
+    }
+
+    const float *values = series->values;
+    return values[index];
+}
+
+void series_close(SeriesFile *series)
+{
+    if (series != NULL && series->mapping != NULL)
+    {
+        munmap(series->mapping, series->mapping_size);
+        memset(series, 0, sizeof(*series));
+    }
+}
+
+// Write the binary file back out in the same layout as write_csv
+int export_series_csv(const char *binary_filename, const char *csv_filename)
+{
+    SeriesFile series;
+    int result = series_open(&series, binary_filename);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    FILE *file = fopen(csv_filename, "w");
+    if (file == NULL)
+    {
+        perror("Error opening file for writing");
+        series_close(&series);
+        return FILE_WRITE_ERROR;
+    }
+
+    const char *filter_name = filter_type_name((FilterType)series.header->filter_type);
+    write_csv_header(file);
+
+    int64_t timestamp = series.header->first_timestamp;
+    for (size_t i = 0; i < series.header->num_samples; i++)
+    {
+        timestamp += series.timestamp_deltas[i];
+        write_csv_row(file, filter_name, timestamp, series_value(&series, i));
+    }
+
+    stats_add_bytes(series.mapping_size, 0);
+    stats_add_file_bytes(file, true);
+    series_close(&series);
+    return (fclose(file) == 0) ? SUCCESS : FILE_WRITE_ERROR;
+}
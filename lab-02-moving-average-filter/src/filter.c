@@ -10,7 +10,29 @@ int apply_filter(float *input, float *output, int num_samples, FilterType filter
         return moving_average_filter(input, output, num_samples, TAPS);
     case LOW_PASS:
         return low_pass_filter(input, output, num_samples, TAPS);
+    case MEDIAN:
+        return median_filter(input, output, num_samples, TAPS);
+    case PERCENTILE:
+        return percentile_filter(input, output, num_samples, TAPS, DEFAULT_PERCENTILE);
     default:
         return UNKNOWN_FILTER_TYPE;
     }
+}
+
+// Human-readable filter name, as written to the output files
+const char *filter_type_name(FilterType filter_type)
+{
+    switch (filter_type)
+    {
+    case MOVING_AVERAGE:
+        return "Moving Average";
+    case LOW_PASS:
+        return "Low Pass";
+    case MEDIAN:
+        return "Median";
+    case PERCENTILE:
+        return "Percentile";
+    default:
+        return "Unknown";
+    }
 }
\ No newline at end of file
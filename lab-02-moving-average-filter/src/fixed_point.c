@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "fixed_point.h"
+#include "error_codes.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Fixed-point filters for integer-only targets
+ * -----------------------------
+ * Samples are scaled by FIXED_FULL_SCALE so that the temperature range fits
+ * in [-1, 1) and stored as Q15 (int16_t) or Q31 (int32_t).
+ *
+ * - Moving average: integer addition is exact, so unlike the float version
+ *   a running sum can be used without any drift. The division by the window
+ *   length is a multiplication with a Q31 reciprocal (Q15) or a single
+ *   integer division (Q31).
+ * - FIR: Q15 products are accumulated in 32 bits (64 bits for Q31) and
+ *   rounded back once at the end. Every narrowing step saturates instead of
+ *   wrapping around.
+ *
+ * The Q15 FIR is a contiguous int16 dot product, which maps directly onto the
+ * SSE2/AVX2 multiply-add instruction (pmaddwd).
+ */
+
+static inline int16_t saturate_q15(int64_t value)
+{
+    if (value > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+static inline int32_t saturate_q31(int64_t value)
+{
+    if (value > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN)
+    {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
+
+void quantize_q15(const float *input, int16_t *output, int num_samples, float full_scale)
+{
+    for (int i = 0; i < num_samples; i++)
+    {
+        output[i] = saturate_q15(llrint((double)input[i] / full_scale * 32768.0));
+    }
+}
+
+void dequantize_q15(const int16_t *input, float *output, int num_samples, float full_scale)
+{
+    for (int i = 0; i < num_samples; i++)
+    {
+        output[i] = (float)(input[i] * (full_scale / 32768.0));
+    }
+}
+
+void quantize_q31(const float *input, int32_t *output, int num_samples, float full_scale)
+{
+    for (int i = 0; i < num_samples; i++)
+    {
+        output[i] = saturate_q31(llrint((double)input[i] / full_scale * 2147483648.0));
+    }
+}
+
+void dequantize_q31(const int32_t *input, float *output, int num_samples, float full_scale)
+{
+    for (int i = 0; i < num_samples; i++)
+    {
+        output[i] = (float)(input[i] * (full_scale / 2147483648.0));
+    }
+}
+
+// Quantised filter coefficients, filled on first use from filter_taps. The
+// first use may be on several worker threads at once (-threads, -pipeline),
+// so the tables are filled exactly once under pthread_once().
+static int16_t taps_q15[LOW_FILTER_TAP_NUM];
+static int32_t taps_q31[LOW_FILTER_TAP_NUM];
+static pthread_once_t taps_once = PTHREAD_ONCE_INIT;
+
+static void quantize_taps(void)
+{
+    quantize_q15(filter_taps, taps_q15, LOW_FILTER_TAP_NUM, 1.0f);
+    quantize_q31(filter_taps, taps_q31, LOW_FILTER_TAP_NUM, 1.0f);
+}
+
+const int16_t *low_pass_taps_q15(void)
+{
+    pthread_once(&taps_once, quantize_taps);
+    return taps_q15;
+}
+
+const int32_t *low_pass_taps_q31(void)
+{
+    pthread_once(&taps_once, quantize_taps);
+    return taps_q31;
+}
+
+static int check_arguments(const void *input, const void *output, int num_samples, int taps)
+{
+    if (input == NULL || output == NULL)
+    {
+        fprintf(stderr, "Error: Input or output array is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_samples <= 0)
+    {
+        fprintf(stderr, "Error: Number of samples must be greater than 0.\n");
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    if (taps <= 0 || taps > MAX_FIXED_TAPS)
+    {
+        fprintf(stderr, "Error: Number of taps must be between 1 and %d.\n", MAX_FIXED_TAPS);
+        return INVALID_TAPS_ERROR;
+    }
+
+    if (taps > num_samples)
+    {
+        fprintf(stderr, "Error: Number of taps (%d) cannot exceed number of samples (%d).\n", taps, num_samples);
+        return TAPS_EXCEEDS_SAMPLES_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+int moving_average_filter_q15(const int16_t *input, int16_t *output, int num_samples, int taps)
+{
+    int result = check_arguments(input, output, num_samples, taps);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    // |sum| <= 32768 * MAX_FIXED_TAPS < 2^31, so the running sum cannot overflow
+    int32_t sum = 0;
+    int count = 0;
+    int64_t reciprocal = 0; // round(2^31 / count)
+
+    for (int i = 0; i < num_samples; i++)
+    {
+        sum += input[i];
+        if (i >= taps)
+        {
+            sum -= input[i - taps]; // Oldest sample leaves the window
+        }
+        else
+        {
+            // The window length only changes while it fills up
+            count++;
+            reciprocal = ((INT64_C(1) << 31) + count / 2) / count;
+        }
+
+        output[i] = saturate_q15((sum * reciprocal + (INT64_C(1) << 30)) >> 31);
+    }
+
+    return SUCCESS;
+}
+
+int moving_average_filter_q31(const int32_t *input, int32_t *output, int num_samples, int taps)
+{
+    int result = check_arguments(input, output, num_samples, taps);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    int64_t sum = 0;
+    int count = 0;
+
+    for (int i = 0; i < num_samples; i++)
+    {
+        sum += input[i];
+        if (i >= taps)
+        {
+            sum -= input[i - taps];
+        }
+        else
+        {
+            count++;
+        }
+
+        // Round half away from zero
+        int64_t half = (sum >= 0) ? count / 2 : -(count / 2);
+        output[i] = saturate_q31((sum + half) / count);
+    }
+
+    return SUCCESS;
+}
+
+// int16 dot product with a 32-bit accumulator.
+// The caller guarantees that the result fits in 32 bits.
+static inline int32_t dot_product_q15(const int16_t *a, const int16_t *b, int length)
+{
+    int32_t acc = 0;
+    int k = 0;
+
+#if defined(__AVX2__)
+    // 16 products per instruction, summed pairwise into eight 32-bit lanes
+    __m256i sum = _mm256_setzero_si256();
+    for (; k + 16 <= length; k += 16)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + k));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + k));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(va, vb));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#elif defined(__SSE2__)
+    __m128i half = _mm_setzero_si128();
+    for (; k + 8 <= length; k += 8)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + k));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + k));
+        half = _mm_add_epi32(half, _mm_madd_epi16(va, vb));
+    }
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // Horizontal sum of the four remaining lanes
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    acc = _mm_cvtsi128_si32(half);
+#endif
+
+    for (; k < length; k++)
+    {
+        acc += (int32_t)a[k] * b[k];
+    }
+
+    return acc;
+}
+
+int fir_filter_q15(const int16_t *input, int16_t *output, int num_samples, const int16_t *taps, int num_taps)
+{
+    int result = check_arguments(input, output, num_samples, 1);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    if (taps == NULL || num_taps <= 0 || num_taps > MAX_FIXED_TAPS)
+    {
+        fprintf(stderr, "Error: Invalid FIR taps.\n");
+        return INVALID_TAPS_ERROR;
+    }
+
+    // Reverse the taps and put num_taps - 1 zeros in front of the input so that
+    // every output is a dot product of two contiguous arrays. The zeros give
+    // the same start-up behaviour as the float filter.
+    int16_t *reversed = malloc((size_t)num_taps * sizeof(int16_t));
+    int16_t *padded = calloc((size_t)num_samples + num_taps - 1, sizeof(int16_t));
+    if (reversed == NULL || padded == NULL)
+    {
+        free(reversed);
+        free(padded);
+        fprintf(stderr, "Error: Failed to allocate the FIR buffers.\n");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    int64_t taps_l1 = 0;
+    for (int j = 0; j < num_taps; j++)
+    {
+        reversed[j] = taps[num_taps - 1 - j];
+        taps_l1 += abs(taps[j]);
+    }
+    memcpy(padded + num_taps - 1, input, (size_t)num_samples * sizeof(int16_t));
+
+    // The 32-bit accumulator is safe when sum(|tap|) * 32768 < 2^31
+    bool fits_32_bits = taps_l1 < 65536;
+
+    for (int i = 0; i < num_samples; i++)
+    {
+        const int16_t *window = padded + i;
+        int64_t acc;
+
+        if (fits_32_bits)
+        {
+            acc = dot_product_q15(reversed, window, num_taps);
+        }
+        else
+        {
+            acc = 0;
+            for (int k = 0; k < num_taps; k++)
+            {
+                acc += (int32_t)reversed[k] * window[k];
+            }
+        }
+
+        output[i] = saturate_q15((acc + (1 << 14)) >> 15); // Q30 -> Q15 with rounding
+    }
+
+    free(reversed);
+    free(padded);
+    return SUCCESS;
+}
+
+int fir_filter_q31(const int32_t *input, int32_t *output, int num_samples, const int32_t *taps, int num_taps)
+{
+    int result = check_arguments(input, output, num_samples, 1);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    if (taps == NULL || num_taps <= 0 || num_taps > MAX_FIXED_TAPS)
+    {
+        fprintf(stderr, "Error: Invalid FIR taps.\n");
+        return INVALID_TAPS_ERROR;
+    }
+
+    for (int i = 0; i < num_samples; i++)
+    {
+        // Q62 products are reduced to Q46 before summing, which leaves 17 bits
+        // of headroom in the 64-bit accumulator
+        int64_t acc = 0;
+        int limit = (i + 1 < num_taps) ? i + 1 : num_taps;
+        for (int j = 0; j < limit; j++)
+        {
+            acc += ((int64_t)taps[j] * input[i - j]) >> 16;
+        }
+
+        output[i] = saturate_q31((acc + (INT64_C(1) << 14)) >> 15); // Q46 -> Q31 with rounding
+    }
+
+    return SUCCESS;
+}
+
+int low_pass_filter_q15(const int16_t *input, int16_t *output, int num_samples, int moving_average_taps)
+{
+    int16_t *smoothed = malloc((size_t)(num_samples > 0 ? num_samples : 1) * sizeof(int16_t));
+    if (smoothed == NULL)
+    {
+        fprintf(stderr, "Error: Failed to allocate the moving average buffer.\n");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    int result = moving_average_filter_q15(input, smoothed, num_samples, moving_average_taps);
+    if (result == SUCCESS)
+    {
+        result = fir_filter_q15(smoothed, output, num_samples, low_pass_taps_q15(), LOW_FILTER_TAP_NUM);
+    }
+
+    free(smoothed);
+    return result;
+}
+
+int low_pass_filter_q31(const int32_t *input, int32_t *output, int num_samples, int moving_average_taps)
+{
+    int32_t *smoothed = malloc((size_t)(num_samples > 0 ? num_samples : 1) * sizeof(int32_t));
+    if (smoothed == NULL)
+    {
+        fprintf(stderr, "Error: Failed to allocate the moving average buffer.\n");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    int result = moving_average_filter_q31(input, smoothed, num_samples, moving_average_taps);
+    if (result == SUCCESS)
+    {
+        result = fir_filter_q31(smoothed, output, num_samples, low_pass_taps_q31(), LOW_FILTER_TAP_NUM);
+    }
+
+    free(smoothed);
+    return result;
+}
+
+int apply_filter_fixed(const float *input, float *output, int num_samples, FilterType filter_type, FixedFormat format)
+{
+    if (input == NULL || output == NULL)
+    {
+        fprintf(stderr, "Error: Input or output array is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_samples <= 0)
+    {
+        fprintf(stderr, "Error: Number of samples must be greater than 0.\n");
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    if (filter_type != MOVING_AVERAGE && filter_type != LOW_PASS)
+    {
+        return UNKNOWN_FILTER_TYPE;
+    }
+
+    int result;
+
+    if (format == FIXED_Q15)
+    {
+        int16_t *samples = malloc((size_t)num_samples * 2 * sizeof(int16_t));
+        if (samples == NULL)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+        int16_t *filtered = samples + num_samples;
+
+        quantize_q15(input, samples, num_samples, FIXED_FULL_SCALE);
+        result = (filter_type == LOW_PASS) ? low_pass_filter_q15(samples, filtered, num_samples, TAPS)
+                                           : moving_average_filter_q15(samples, filtered, num_samples, TAPS);
+        if (result == SUCCESS)
+        {
+            dequantize_q15(filtered, output, num_samples, FIXED_FULL_SCALE);
+        }
+
+        free(samples);
+    }
+    else if (format == FIXED_Q31)
+    {
+        int32_t *samples = malloc((size_t)num_samples * 2 * sizeof(int32_t));
+        if (samples == NULL)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+        int32_t *filtered = samples + num_samples;
+
+        quantize_q31(input, samples, num_samples, FIXED_FULL_SCALE);
+        result = (filter_type == LOW_PASS) ? low_pass_filter_q31(samples, filtered, num_samples, TAPS)
+                                           : moving_average_filter_q31(samples, filtered, num_samples, TAPS);
+        if (result == SUCCESS)
+        {
+            dequantize_q31(filtered, output, num_samples, FIXED_FULL_SCALE);
+        }
+
+        free(samples);
+    }
+    else
+    {
+        result = INVALID_ARGUMENT;
+    }
+
+    return result;
+}
@@ -1,98 +1,157 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "filter.h"
 #include "error_codes.h"
+#include "io.h"
+#include "timestamp.h"
+#include "stats.h"
 
-// 'const char *filename' is a pointer to a constant string representing the
-// filename to be read. The 'const' qualifier ensures the function does not
-// modify the string, promoting safer code and preventing accidental changes.
-
-// The size for 'char timestamps[MAX_SAMPLES][20]' is specified to inform the compiler
-// how to correctly calculate the addresses of the elements in the second
-// dimension. For single-dimensional arrays like 'float input_data[MAX_SAMPLES]',
-// the size is not needed in the function parameter because C can work with just
-// the pointer to the first element.
-int read_csv(const char *filename, float *data, char timestamps[MAX_SAMPLES][20], int *num_samples)
+// Open a CSV file and skip its header line.
+// The reader keeps no sample buffer of its own, so files of any length can be
+// processed one row at a time.
+int csv_reader_open(CsvReader *reader, const char *filename)
 {
+    if (reader == NULL || filename == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    reader->rows_read = 0;
+    reader->rows_rejected = 0;
+
     // FILE *file is a pointer to a FILE structure that represents an open file.
     // Using a pointer allows the program to manage the file's state (like the current
     // read/write position) without needing to know the details of the FILE structure.
     // It also enables dynamic memory management, as fopen allocates memory for the FILE
     // structure and returns a pointer to it, allowing multiple operations on the same
     // file while maintaining its state.
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) // same as if (!file)
+    reader->file = fopen(filename, "r");
+    if (reader->file == NULL) // same as if (!file)
     {
         perror("Error opening file for reading"); // Use perror to display error message
         return FILE_NOT_FOUND;
     }
 
-    char line[50]; // Buffer to hold each line of the CSV
-    int i = 0;
+    char line[CSV_LINE_LENGTH];
 
     // Skip the header line
     // fgets function reads and discards the header/first line from the CSV file
     // fgets also moves the file pointer forward to the beginning of the next/second line
-    if (fgets(line, sizeof(line), file) == NULL)
+    if (fgets(line, sizeof(line), reader->file) == NULL)
     {
-        fclose(file);
+        csv_reader_close(reader);
         return FILE_HAS_NO_CONTENT; // If the file is empty or has no valid lines
     }
 
-    // Read the data line by line startin from the second one
-    while (fgets(line, sizeof(line), file) != NULL && i < MAX_SAMPLES)
+    return SUCCESS;
+}
+
+// Read the next valid row. Lines whose timestamp or value cannot be parsed are
+// skipped and counted in 'rows_rejected'. Returns false at the end of the file.
+bool csv_reader_next(CsvReader *reader, int64_t *timestamp, float *value)
+{
+    char line[CSV_LINE_LENGTH]; // Buffer to hold each line of the CSV
+
+    while (fgets(line, sizeof(line), reader->file) != NULL)
     {
-        // Pointer to store the entire token (string) returned by strtok(), not just one char.
-
-        // First call to strtok(line, ","):
-        //  - The input string 'line' is "2024-10-13T07:00,15.5".
-        //  - strtok() scans until the first comma and replaces it with a null terminator '\0'.
-        //  - Now, 'line' becomes: "2024-10-13T07:00\015.5" (comma replaced by '\0').
-        //  - Pointer 'token' points to the first token, which is "2024-10-13T07:00".
-        char *token = strtok(line, ",");
-        if (token != NULL) // Ensures that the first token was successfully found and is not NULL
+        // A line that does not fit in the buffer is not a valid row;
+        // drop the rest of it so that it is not read as a separate line
+        if (strchr(line, '\n') == NULL && !feof(reader->file))
         {
-            // Copy the token (timestamp) to the timestamps array
-            // If the source string is shorter than the specified number, strncpy will fill the
-            // remaining space in the destination with null characters. However, if the source
-            // string is equal to or longer than the specified number, strncpy will not
-            // automatically add a null terminator and that's when we need next step.
-            strncpy(timestamps[i], token, sizeof(timestamps[i]));
-
-            // Ensure null termination by setting the last character of the array to '\0'
-            // This guarantees the string is properly terminated
-            timestamps[i][sizeof(timestamps[i]) - 1] = '\0';
+            int c;
+            while ((c = fgetc(reader->file)) != '\n' && c != EOF)
+            {
+            }
+            reader->rows_rejected++;
+            continue;
         }
 
-        // Second call to strtok(NULL, ","):
-        //  - strtok(NULL, ",") resumes scanning the same string after the first null terminator.
-        //  - It starts scanning after "2024-10-13T07:00\0", where the second token starts.
-        //  - Pointer 'token' now points to the second token, which is "15.5".
-        token = strtok(NULL, ",");
-        if (token != NULL)
+        // The line looks like "2024-10-13T07:00,15.5": the timestamp is parsed
+        // straight from the start of the line into seconds, and the value
+        // starts right after the first comma.
+        char *comma = strchr(line, ',');
+        if (comma == NULL || parse_timestamp(line, timestamp) != SUCCESS)
         {
-            // Convert pointer to the string 'token' to a float and store the temperature.
-            // The strtof function converts a C string (character array) to a float,
-            // scanning for a valid floating-point number representation while skipping
-            // leading whitespace. It returns the converted float value.
-            // The second parameter, set to NULL, indicates where to stop parsing;
-            // in this case, we don't need to know where the conversion stopped
-            // since we're only interested in the float value. If the string is
-            // not a valid number, it returns 0.0.
-            data[i] = strtof(token, NULL);
-            i++;
+            reader->rows_rejected++;
+            continue;
         }
+
+        // The strtof function converts a C string (character array) to a float,
+        // scanning for a valid floating-point number representation while skipping
+        // leading whitespace. The second parameter tells where parsing stopped,
+        // which is used to detect a missing or non-numeric value.
+        char *end;
+        *value = strtof(comma + 1, &end);
+        if (end == comma + 1 || isnan(*value)) // "nan" parses, but is not a reading
+        {
+            reader->rows_rejected++;
+            continue;
+        }
+
+        reader->rows_read++;
+        return true;
     }
+
+    return false;
+}
+
+void csv_reader_close(CsvReader *reader)
+{
+    if (reader != NULL && reader->file != NULL)
+    {
+        stats_add_rows(reader->rows_read, reader->rows_rejected);
+        stats_add_file_bytes(reader->file, false);
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+// 'const char *filename' is a pointer to a constant string representing the
+// filename to be read. The 'const' qualifier ensures the function does not
+// modify the string, promoting safer code and preventing accidental changes.
+int read_csv(const char *filename, float *data, int64_t *timestamps, int *num_samples)
+{
+    CsvReader reader;
+    int result = csv_reader_open(&reader, filename);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    int i = 0;
+
+    // Read the data row by row until the file ends or the arrays are full
+    while (i < MAX_SAMPLES && csv_reader_next(&reader, &timestamps[i], &data[i]))
+    {
+        i++;
+    }
+
     // By passing the address of 'num_samples' (&), we can modify its value directly in the
     // function. This allows us to update the actual data via the pointer (*num_samples)
     // without needing to return anything.
     *num_samples = i; // Store the actual number of samples read
-    fclose(file);
+    csv_reader_close(&reader);
     return (i > 0) ? SUCCESS : FILE_HAS_NO_CONTENT; // Check if any data was read
 }
 
-int write_csv(const char *filename, float *data, char timestamps[MAX_SAMPLES][20], int num_samples, FilterType filter_type)
+// Header line of the filtered CSV files
+void write_csv_header(FILE *file)
+{
+    fprintf(file, "FilterType,DateTime,Temperature (°C)\n");
+}
+
+// One row of the filtered CSV files; every writer goes through here so that
+// the sequential, pipelined and exported outputs are identical
+void write_csv_row(FILE *file, const char *filter_name, int64_t timestamp, float value)
+{
+    char text[TIMESTAMP_LENGTH];
+    format_timestamp(timestamp, text, sizeof(text));
+    fprintf(file, "%s,%s,%.2f\n", filter_name, text, value); // Write timestamp and temperature
+}
+
+int write_csv(const char *filename, float *data, int64_t *timestamps, int num_samples, FilterType filter_type)
 {
     FILE *file = fopen(filename, "w");
     if (file == NULL)
@@ -101,28 +160,17 @@ int write_csv(const char *filename, float *data, char timestamps[MAX_SAMPLES][20
         return FILE_WRITE_ERROR;
     }
 
-    const char *filter_name;
-    if (filter_type == MOVING_AVERAGE)
-    {
-        filter_name = "Moving Average";
-    }
-    else if (filter_type == LOW_PASS)
-    {
-        filter_name = "Low Pass";
-    }
-    else
-    {
-        filter_name = "Unknown";
-    }
+    const char *filter_name = filter_type_name(filter_type);
 
     // Write the header line including filter type
-    fprintf(file, "FilterType,DateTime,Temperature (°C)\n");
+    write_csv_header(file);
 
     for (int i = 0; i < num_samples; i++)
     {
-        fprintf(file, "%s,%s,%.2f\n", filter_name, timestamps[i], data[i]); // Write timestamp and temperature
+        write_csv_row(file, filter_name, timestamps[i], data[i]);
     }
 
+    stats_add_file_bytes(file, true);
     fclose(file);
     return SUCCESS;
 }
\ No newline at end of file
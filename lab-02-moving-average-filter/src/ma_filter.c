@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include "filter.h"
+#include "stream_filter.h"
 #include "error_codes.h"
 
 /*
@@ -48,6 +49,9 @@
  * Explanation:
  * The moving average "slides" over the input array, recalculating the average at each step by including
  * the next sample and discarding the oldest one (once enough samples are available to fill the window).
+ *
+ * The sliding window itself is kept by a StreamFilter (see stream_filter.c), this function only
+ * validates the arguments and pushes the whole array through it.
  */
 
 int moving_average_filter(float *input, float *output, int num_samples, int taps)
@@ -76,30 +80,15 @@ int moving_average_filter(float *input, float *output, int num_samples, int taps
         return TAPS_EXCEEDS_SAMPLES_ERROR;
     }
 
-    for (int i = 0; i < num_samples; i++) // Loop through each sample in the input array
+    StreamFilter *filter;
+    int result = stream_filter_create(&filter, MOVING_AVERAGE, taps);
+    if (result != SUCCESS)
     {
-        // Sum of the values in the current window
-        // Reset to 0 at the start of each iteration/window
-        float sum = 0;
-
-        // Amount of samples in the current window
-        // Also reset at the start of each iteration
-        int count = 0;
-
-        // Calculate moving average for the current window
-        for (int j = 0; j < taps; j++)
-        {
-            if (i - j >= 0) // Check that we don't go out of bounds (negative indices)
-            {
-                sum += input[i - j]; // Add the value of the current sample (or previous samples) to the sum
-                count++;             // Count how many valid samples have been summed for the current window
-            }
-        }
-
-        // Store the average in the output array
-        // Average based on how many samples were counted
-        output[i] = sum / count;
+        return result;
     }
 
-    return SUCCESS;
+    result = stream_filter_push_block(filter, input, output, num_samples);
+    stream_filter_destroy(filter);
+
+    return result;
 }
\ No newline at end of file
@@ -1,8 +1,52 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
 #include "filter.h"
 #include "error_codes.h"
 #include "io.h"
+#include "resample.h"
+#include "aggregate.h"
+#include "binary_io.h"
+#include "fixed_point.h"
+#include "pipeline.h"
+#include "parallel_filter.h"
+#include "stats.h"
+
+// Print how far the fixed-point filter output is from the float reference
+static void report_fixed_error(const float *reference, const float *fixed, int num_samples, FixedFormat format)
+{
+    double max_error = 0.0;
+    double sum_squared = 0.0;
+    int worst_index = 0;
+
+    for (int i = 0; i < num_samples; i++)
+    {
+        double error = fabs((double)fixed[i] - reference[i]);
+        sum_squared += error * error;
+        if (error > max_error)
+        {
+            max_error = error;
+            worst_index = i;
+        }
+    }
+
+    printf("%s vs float: max error %.6f (sample %d), RMS error %.6f, LSB %.3g\n",
+           (format == FIXED_Q15) ? "Q15" : "Q31", max_error, worst_index, sqrt(sum_squared / num_samples),
+           FIXED_FULL_SCALE / ((format == FIXED_Q15) ? 32768.0 : 2147483648.0));
+}
+
+static uint64_t run_start; // Start of the timed part of main, for the --stats total
+
+// Registered with atexit() so that the report is also printed when main
+// returns early with an error, e.g. to show how many rows were rejected
+static void print_stats(void)
+{
+    stats_stop(STAGE_TOTAL, run_start);
+    stats_print_json(stderr);
+}
 
 // 'argc' is the argument count, indicating the number of command-line arguments.
 
@@ -19,6 +63,7 @@ int main(int argc, char *argv[])
     const char *output_filename = "../data/filtered_data.csv";
 
     FilterType filter_type = MOVING_AVERAGE; // Default filter type
+    float percentile = DEFAULT_PERCENTILE;   // Only used by the percentile filter
 
     // If an input file was provided use it instead of the default
     if (argc >= 2)
@@ -32,36 +77,202 @@ int main(int argc, char *argv[])
         output_filename = argv[2]; // Output file from command-line arguments
     }
 
-    // Check the first argument (argv[1]) for filter type
-    if (argc >= 4) // Ensure we have at least 4 arguments to check
+    int decimation = 1;       // Output every sample unless a decimation factor is given
+    bool aggregate = false;   // Calendar aggregation instead of filtering
+    BucketSize bucket_size = BUCKET_DAY;
+    bool binary_output = false; // Binary columnar output instead of CSV
+    ValueEncoding value_encoding = VALUE_FLOAT32;
+    bool export_csv = false; // Convert a binary series file back to CSV
+    FixedFormat fixed_format = FIXED_NONE; // Integer-only arithmetic instead of float
+    bool pipeline = false; // Threaded read/filter/write instead of whole-file arrays
+    int num_threads = 1;   // Filter threads, 0 for one per CPU
+
+    // Options after the file names: the filter type and an optional rate reduction stage
+    for (int i = 3; i < argc; i++)
     {
-        if (strcmp(argv[3], "-low") == 0)
+        if (strcmp(argv[i], "-low") == 0)
         {
             filter_type = LOW_PASS; // Set to Low Pass filter
         }
-        else if (strcmp(argv[3], "-ma") == 0)
+        else if (strcmp(argv[i], "-ma") == 0)
         {
             filter_type = MOVING_AVERAGE; // Set to Moving Average filter
         }
+        else if (strcmp(argv[i], "-median") == 0)
+        {
+            filter_type = MEDIAN; // Set to sliding median filter
+        }
+        else if (strcmp(argv[i], "-pct") == 0 && i + 1 < argc)
+        {
+            // Sliding percentile filter, e.g. -pct 90
+            filter_type = PERCENTILE;
+            percentile = strtof(argv[++i], NULL);
+            if (percentile < 0.0f || percentile > 100.0f)
+            {
+                fprintf(stderr, "Invalid percentile. Use a value between 0 and 100.\n");
+                return INVALID_ARGUMENT;
+            }
+        }
+        else if (strcmp(argv[i], "-decimate") == 0 && i + 1 < argc)
+        {
+            // Keep every N-th sample after an anti-aliasing polyphase filter
+            decimation = atoi(argv[++i]);
+            if (decimation <= 0 || decimation > MAX_RESAMPLE_FACTOR)
+            {
+                fprintf(stderr, "Invalid decimation factor. Use a value between 1 and %d.\n", MAX_RESAMPLE_FACTOR);
+                return INVALID_ARGUMENT;
+            }
+        }
+        else if (strcmp(argv[i], "-agg") == 0 && i + 1 < argc)
+        {
+            // Reduce the raw readings to per-day/week/month statistics
+            aggregate = true;
+            i++;
+            if (strcmp(argv[i], "day") == 0)
+            {
+                bucket_size = BUCKET_DAY;
+            }
+            else if (strcmp(argv[i], "week") == 0)
+            {
+                bucket_size = BUCKET_WEEK;
+            }
+            else if (strcmp(argv[i], "month") == 0)
+            {
+                bucket_size = BUCKET_MONTH;
+            }
+            else
+            {
+                fprintf(stderr, "Invalid aggregation period. Use day, week or month.\n");
+                return INVALID_ARGUMENT;
+            }
+        }
+        else if (strcmp(argv[i], "-bin") == 0)
+        {
+            binary_output = true; // float32 values
+            value_encoding = VALUE_FLOAT32;
+        }
+        else if (strcmp(argv[i], "-bin16") == 0)
+        {
+            binary_output = true; // Quantised int16 values
+            value_encoding = VALUE_INT16;
+        }
+        else if (strcmp(argv[i], "-export") == 0)
+        {
+            export_csv = true;
+        }
+        else if (strcmp(argv[i], "-q15") == 0)
+        {
+            fixed_format = FIXED_Q15;
+        }
+        else if (strcmp(argv[i], "-q31") == 0)
+        {
+            fixed_format = FIXED_Q31;
+        }
+        else if (strcmp(argv[i], "-pipeline") == 0)
+        {
+            pipeline = true;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            // Stage timings and counters as JSON on stderr
+            filter_stats.enabled = true;
+        }
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+        {
+            // Split the series into chunks filtered in parallel
+            num_threads = atoi(argv[++i]);
+            if (num_threads < 0 || num_threads > MAX_FILTER_THREADS)
+            {
+                fprintf(stderr, "Invalid thread count. Use a value between 0 (all CPUs) and %d.\n", MAX_FILTER_THREADS);
+                return INVALID_ARGUMENT;
+            }
+        }
         else
         {
-            fprintf(stderr, "Invalid filter type argument. Use -ma for Moving Average or -low for Low Pass.\n");
+            fprintf(stderr, "Invalid filter type argument. Use -ma for Moving Average, -low for Low Pass, -median or -pct P, "
+                            "optionally followed by -q15/-q31, -decimate N and -bin/-bin16, or -agg day|week|month, "
+                            "or -export, or -pipeline, or -threads N, and --stats.\n");
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    if (filter_stats.enabled)
+    {
+        run_start = stats_start();
+        atexit(print_stats);
+    }
+
+    // The input is a binary series file written with -bin/-bin16
+    if (export_csv)
+    {
+        uint64_t start = stats_start();
+        ErrorCode export_result = export_series_csv(input_filename, output_filename);
+        stats_stop(STAGE_EXPORT, start);
+        if (export_result != SUCCESS)
+        {
+            fprintf(stderr, "Error exporting file: %s (Error code: %d)\n", input_filename, export_result);
+            return export_result;
+        }
+
+        printf("Export completed. Results saved to %s\n", output_filename);
+        return SUCCESS;
+    }
+
+    // The pipeline streams blocks from the input to the output file and only
+    // supports the plain filters with CSV output
+    if (pipeline)
+    {
+        if (decimation > 1 || binary_output || fixed_format != FIXED_NONE || aggregate || export_csv ||
+            num_threads != 1)
+        {
+            fprintf(stderr, "Invalid arguments. -pipeline cannot be combined with -decimate, -bin/-bin16, "
+                            "-q15/-q31, -agg, -export or -threads.\n");
             return INVALID_ARGUMENT;
         }
+
+        ErrorCode pipeline_result = run_pipeline(input_filename, output_filename, filter_type, percentile);
+        if (pipeline_result != SUCCESS)
+        {
+            fprintf(stderr, "Error filtering file: %s (Error code: %d)\n", input_filename, pipeline_result);
+            return pipeline_result;
+        }
+
+        printf("Filtering completed. Results saved to %s\n", output_filename);
+        return SUCCESS;
+    }
+
+    // Aggregation streams through the input file, so it is not limited by MAX_SAMPLES
+    if (aggregate)
+    {
+        uint64_t start = stats_start();
+        ErrorCode aggregate_result = aggregate_csv(input_filename, output_filename, bucket_size);
+        stats_stop(STAGE_AGGREGATE, start);
+        if (aggregate_result != SUCCESS)
+        {
+            fprintf(stderr, "Error aggregating data from file: %s (Error code: %d)\n", input_filename, aggregate_result);
+            return aggregate_result;
+        }
+
+        printf("Aggregation completed. Results saved to %s\n", output_filename);
+        return SUCCESS;
     }
 
     // float instead of double for efficiency, as high precision isn't required for temperature readings
     float input_data[MAX_SAMPLES];
     float filtered_data[MAX_SAMPLES];
+    float fixed_data[MAX_SAMPLES]; // Fixed-point result, only used with -q15/-q31
 
-    // 2D array used to store date-time strings efficiently in memory, each up to 19 characters + null terminator
-    char timestamps[MAX_SAMPLES][20];
+    // Timestamps as seconds since the epoch, which takes less memory than the
+    // text form and allows time arithmetic (see timestamp.h)
+    int64_t timestamps[MAX_SAMPLES];
     int num_samples = 0;
 
     // Read input data from the CSV file
     // &num_samples passes by reference the address of num_samples, allowing the
     // function to modify the value of num_samples in the main function using pionters
+    uint64_t start = stats_start();
     ErrorCode read_result = read_csv(input_filename, input_data, timestamps, &num_samples);
+    stats_stop(STAGE_READ, start);
     if (read_result != SUCCESS)
     {
         fprintf(stderr, "Error reading from file: %s (Error code: %d)\n", input_filename, read_result);
@@ -69,15 +280,86 @@ int main(int argc, char *argv[])
     }
 
     // Apply the selected filter (moving average in this case)
-    ErrorCode filter_result = apply_filter(input_data, filtered_data, num_samples, filter_type);
+    // Input values, timestamps and filter output
+    stats_buffer_usage((size_t)num_samples * (2 * sizeof(float) + sizeof(int64_t)));
+
+    start = stats_start();
+    ErrorCode filter_result;
+    if (num_threads != 1)
+    {
+        filter_result = parallel_filter(input_data, filtered_data, (size_t)num_samples, filter_type, TAPS, percentile,
+                                        num_threads);
+    }
+    else if (filter_type == PERCENTILE)
+    {
+        filter_result = percentile_filter(input_data, filtered_data, num_samples, TAPS, percentile);
+    }
+    else
+    {
+        filter_result = apply_filter(input_data, filtered_data, num_samples, filter_type);
+    }
+    stats_stop(STAGE_FILTER, start);
     if (filter_result != SUCCESS)
     {
         fprintf(stderr, "Error applying filter (Error code: %d)\n", filter_result);
         return filter_result;
     }
+    stats_add_samples(num_samples);
 
-    // Write the filtered data to the output CSV file
-    ErrorCode write_result = write_csv(output_filename, filtered_data, timestamps, num_samples, filter_type);
+    // Run the fixed-point version of the filter and compare it with the float result
+    if (fixed_format != FIXED_NONE)
+    {
+        start = stats_start();
+        ErrorCode fixed_result = apply_filter_fixed(input_data, fixed_data, num_samples, filter_type, fixed_format);
+        stats_stop(STAGE_FIXED_POINT, start);
+        stats_buffer_usage((size_t)num_samples * (3 * sizeof(float) + sizeof(int64_t)));
+        if (fixed_result != SUCCESS)
+        {
+            fprintf(stderr, "Error applying fixed-point filter (Error code: %d)\n", fixed_result);
+            return fixed_result;
+        }
+
+        report_fixed_error(filtered_data, fixed_data, num_samples, fixed_format);
+        memcpy(filtered_data, fixed_data, (size_t)num_samples * sizeof(float)); // Write the fixed-point result
+    }
+
+    // Reduce the sample rate before writing, so the output file only holds what is needed
+    if (decimation > 1)
+    {
+        int num_decimated = 0;
+        start = stats_start();
+        ErrorCode decimate_result = decimate_filter(filtered_data, num_samples, input_data, MAX_SAMPLES,
+                                                    decimation, &num_decimated);
+        stats_stop(STAGE_DECIMATE, start);
+        if (decimate_result != SUCCESS)
+        {
+            fprintf(stderr, "Error decimating data (Error code: %d)\n", decimate_result);
+            return decimate_result;
+        }
+
+        // Output m corresponds to input sample m * decimation. The copy never
+        // overwrites a timestamp that is still needed because m <= m * decimation.
+        for (int m = 0; m < num_decimated; m++)
+        {
+            filtered_data[m] = input_data[m];
+            timestamps[m] = timestamps[m * decimation];
+        }
+        num_samples = num_decimated;
+    }
+
+    // Write the filtered data to the output CSV or binary file
+    start = stats_start();
+    ErrorCode write_result;
+    if (binary_output)
+    {
+        write_result = write_series_binary(output_filename, filtered_data, timestamps, num_samples,
+                                           filter_type, decimation, value_encoding);
+    }
+    else
+    {
+        write_result = write_csv(output_filename, filtered_data, timestamps, num_samples, filter_type);
+    }
+    stats_stop(STAGE_WRITE, start);
     if (write_result != SUCCESS)
     {
         fprintf(stderr, "Error writing to file: %s (Error code: %d)\n", output_filename, write_result);
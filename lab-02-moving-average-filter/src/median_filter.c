@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include "filter.h"
+#include "stream_filter.h"
+#include "error_codes.h"
+
+/*
+ * Function: percentile_filter
+ * -----------------------------
+ * Replaces every sample by the given percentile of the last 'taps' samples
+ * (fewer at the start, like the moving average).
+ *
+ * Unlike an average, a percentile ignores how far an outlier is from the rest
+ * of the window. A single-sample spike therefore disappears completely from
+ * the median output instead of being smeared over 'taps' outputs.
+ *
+ * Sorting the window for every sample would cost O(w log w). The stream filter
+ * keeps the window in an indexable skiplist instead, so each step is one
+ * O(log w) insert, one O(log w) removal and an O(log w) rank lookup.
+ *
+ * Example (taps = 3, median):
+ *
+ * Input:  [10, 11, 90, 12, 13]
+ * Output: [10, 10.5, 11, 12, 13] -> the spike of 90 never reaches the output.
+ */
+int percentile_filter(float *input, float *output, int num_samples, int taps, float percentile)
+{
+    if (input == NULL || output == NULL) // Check for null pointers
+    {
+        fprintf(stderr, "Error: Input or output array is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_samples <= 0) // Check if the number of samples is valid
+    {
+        fprintf(stderr, "Error: Number of samples must be greater than 0.\n");
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    if (taps <= 0) // Check if taps is valid
+    {
+        fprintf(stderr, "Error: Number of taps must be greater than 0.\n");
+        return INVALID_TAPS_ERROR;
+    }
+
+    if (taps > num_samples) // Ensure taps does not exceed the number of samples
+    {
+        fprintf(stderr, "Error: Number of taps (%d) cannot exceed number of samples (%d).\n", taps, num_samples);
+        return TAPS_EXCEEDS_SAMPLES_ERROR;
+    }
+
+    StreamFilter *filter;
+    int result = stream_filter_create_percentile(&filter, taps, percentile);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    result = stream_filter_push_block(filter, input, output, num_samples);
+    stream_filter_destroy(filter);
+
+    return result;
+}
+
+// The median is the 50th percentile
+int median_filter(float *input, float *output, int num_samples, int taps)
+{
+    return percentile_filter(input, output, num_samples, taps, 50.0f);
+}
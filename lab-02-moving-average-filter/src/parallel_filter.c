@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "parallel_filter.h"
+#include "stream_filter.h"
+#include "spsc_queue.h"
+#include "error_codes.h"
+
+// Range of chunk indices still owned by a worker, packed as begin | end << 32
+// so that the owner and the thieves can update it with one compare-and-swap.
+// Padded to a cache line, the owner updates it for every chunk.
+typedef struct
+{
+    alignas(CACHE_LINE_SIZE) _Atomic uint64_t range;
+} WorkRange;
+
+typedef struct
+{
+    const float *input;
+    float *output;
+    size_t num_samples;
+    size_t num_chunks;
+    FilterType filter_type;
+    int taps;
+    float percentile;
+    int halo;
+
+    int num_workers;
+    WorkRange *ranges;    // One per worker
+    atomic_int status;    // First error raised by a worker
+} ParallelJob;
+
+typedef struct
+{
+    ParallelJob *job;
+    int index;
+} Worker;
+
+static inline uint64_t pack_range(uint32_t begin, uint32_t end)
+{
+    return (uint64_t)begin | ((uint64_t)end << 32);
+}
+
+static inline uint32_t range_begin(uint64_t range)
+{
+    return (uint32_t)range;
+}
+
+static inline uint32_t range_end(uint64_t range)
+{
+    return (uint32_t)(range >> 32);
+}
+
+int filter_halo_length(FilterType filter_type, int taps)
+{
+    // Each low-pass output also depends on the previous LOW_FILTER_TAP_NUM - 1
+    // moving averages, each of which reaches 'taps - 1' samples further back
+    if (filter_type == LOW_PASS)
+    {
+        return (taps - 1) + (LOW_FILTER_TAP_NUM - 1);
+    }
+
+    return taps - 1;
+}
+
+// Take the next chunk from the front of the worker's own range
+static bool take_own(WorkRange *own, uint32_t *chunk)
+{
+    uint64_t range = atomic_load_explicit(&own->range, memory_order_acquire);
+    while (range_begin(range) < range_end(range))
+    {
+        uint64_t taken = pack_range(range_begin(range) + 1, range_end(range));
+        if (atomic_compare_exchange_weak_explicit(&own->range, &range, taken, memory_order_acq_rel,
+                                                  memory_order_acquire))
+        {
+            *chunk = range_begin(range);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Move the upper half of another worker's range into our own (empty) range
+static bool steal(ParallelJob *job, int thief)
+{
+    for (int offset = 1; offset < job->num_workers; offset++)
+    {
+        WorkRange *victim = &job->ranges[(thief + offset) % job->num_workers];
+        uint64_t range = atomic_load_explicit(&victim->range, memory_order_acquire);
+
+        while (range_begin(range) < range_end(range))
+        {
+            uint32_t begin = range_begin(range);
+            uint32_t end = range_end(range);
+            uint32_t middle = begin + (end - begin) / 2; // The victim keeps the lower half (may be empty)
+
+            if (atomic_compare_exchange_weak_explicit(&victim->range, &range, pack_range(begin, middle),
+                                                      memory_order_acq_rel, memory_order_acquire))
+            {
+                atomic_store_explicit(&job->ranges[thief].range, pack_range(middle, end), memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Filter one chunk: warm the reset filter up on the halo, then produce the outputs
+static int filter_chunk(ParallelJob *job, StreamFilter *filter, uint32_t chunk)
+{
+    size_t start = (size_t)chunk * PARALLEL_CHUNK_SIZE;
+    size_t stop = start + PARALLEL_CHUNK_SIZE;
+    if (stop > job->num_samples)
+    {
+        stop = job->num_samples;
+    }
+    size_t warmup = (start > (size_t)job->halo) ? start - job->halo : 0;
+
+    stream_filter_reset(filter);
+
+    float discarded;
+    for (size_t i = warmup; i < start; i++)
+    {
+        int result = stream_filter_push(filter, job->input[i], &discarded);
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+    }
+
+    return stream_filter_push_block(filter, job->input + start, job->output + start, (int)(stop - start));
+}
+
+static void *worker_thread(void *argument)
+{
+    Worker *worker = argument;
+    ParallelJob *job = worker->job;
+
+    StreamFilter *filter;
+    int result;
+    if (job->filter_type == PERCENTILE)
+    {
+        result = stream_filter_create_percentile(&filter, job->taps, job->percentile);
+    }
+    else
+    {
+        result = stream_filter_create(&filter, job->filter_type, job->taps);
+    }
+
+    if (result == SUCCESS)
+    {
+        uint32_t chunk;
+        while (atomic_load_explicit(&job->status, memory_order_relaxed) == SUCCESS)
+        {
+            if (!take_own(&job->ranges[worker->index], &chunk))
+            {
+                if (!steal(job, worker->index))
+                {
+                    break; // Every range is empty
+                }
+                continue;
+            }
+
+            result = filter_chunk(job, filter, chunk);
+            if (result != SUCCESS)
+            {
+                break;
+            }
+        }
+        stream_filter_destroy(filter);
+    }
+
+    if (result != SUCCESS)
+    {
+        int expected = SUCCESS;
+        atomic_compare_exchange_strong(&job->status, &expected, result);
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: parallel_filter
+ * -----------------------------
+ * Applies the selected filter to 'num_samples' samples using several threads.
+ *
+ * Each output depends only on a bounded number of previous samples (the halo):
+ * 'taps - 1' for the moving average, median and percentile, and another
+ * LOW_FILTER_TAP_NUM - 1 moving averages for the low-pass filter. The stream
+ * filters compute every output directly from the window contents, without
+ * running sums carried over from earlier samples, so restarting them 'halo'
+ * samples before a chunk reproduces the serial output bit for bit.
+ *
+ * Returns:
+ * - SUCCESS on successful completion.
+ * - NULL_POINTER_ERROR if input or output is NULL.
+ * - INVALID_NUM_SAMPLES_ERROR if num_samples is 0 or too large.
+ * - INVALID_TAPS_ERROR if taps is less than or equal to 0, or exceeds
+ *   num_samples for the low-pass filter.
+ * - TAPS_EXCEEDS_SAMPLES_ERROR if taps exceeds num_samples.
+ * - MEMORY_ALLOCATION_ERROR if the worker state cannot be allocated.
+ */
+int parallel_filter(const float *input, float *output, size_t num_samples, FilterType filter_type, int taps,
+                    float percentile, int num_threads)
+{
+    if (input == NULL || output == NULL)
+    {
+        fprintf(stderr, "Error: Input or output array is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    // Chunk indices are kept in 32 bits
+    if (num_samples == 0 || num_samples / PARALLEL_CHUNK_SIZE >= UINT32_MAX)
+    {
+        fprintf(stderr, "Error: Invalid number of samples (%zu).\n", num_samples);
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    if (taps <= 0)
+    {
+        fprintf(stderr, "Error: Number of taps must be greater than 0.\n");
+        return INVALID_TAPS_ERROR;
+    }
+
+    // Same check and error codes as the serial filters
+    if ((size_t)taps > num_samples)
+    {
+        fprintf(stderr, "Error: Number of taps (%d) cannot exceed number of samples (%zu).\n", taps, num_samples);
+        return (filter_type == LOW_PASS) ? INVALID_TAPS_ERROR : TAPS_EXCEEDS_SAMPLES_ERROR;
+    }
+
+    if (num_threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (cpus > 0) ? (int)cpus : 1;
+    }
+    if (num_threads > MAX_FILTER_THREADS)
+    {
+        num_threads = MAX_FILTER_THREADS;
+    }
+
+    size_t num_chunks = (num_samples + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+    if ((size_t)num_threads > num_chunks)
+    {
+        num_threads = (int)num_chunks;
+    }
+
+    ParallelJob job = {
+        .input = input,
+        .output = output,
+        .num_samples = num_samples,
+        .num_chunks = num_chunks,
+        .filter_type = filter_type,
+        .taps = taps,
+        .percentile = percentile,
+        .halo = filter_halo_length(filter_type, taps),
+        .num_workers = num_threads,
+    };
+    atomic_init(&job.status, SUCCESS);
+
+    job.ranges = aligned_alloc(CACHE_LINE_SIZE, (size_t)num_threads * sizeof(WorkRange));
+    Worker *workers = malloc((size_t)num_threads * sizeof(Worker));
+    pthread_t *threads = malloc((size_t)num_threads * sizeof(pthread_t));
+    if (job.ranges == NULL || workers == NULL || threads == NULL)
+    {
+        fprintf(stderr, "Error: Failed to allocate the worker state.\n");
+        free(job.ranges);
+        free(workers);
+        free(threads);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    // Contiguous initial ranges, so neighbouring chunks stay on the same core
+    // unless the load becomes uneven
+    for (int i = 0; i < num_threads; i++)
+    {
+        uint32_t begin = (uint32_t)(num_chunks * i / num_threads);
+        uint32_t end = (uint32_t)(num_chunks * (i + 1) / num_threads);
+        atomic_init(&job.ranges[i].range, pack_range(begin, end));
+        workers[i].job = &job;
+        workers[i].index = i;
+    }
+
+    // The calling thread acts as worker 0
+    int started = 1;
+    for (; started < num_threads; started++)
+    {
+        if (pthread_create(&threads[started], NULL, worker_thread, &workers[started]) != 0)
+        {
+            break; // The remaining ranges get stolen by the running workers
+        }
+    }
+
+    worker_thread(&workers[0]);
+
+    for (int i = 1; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(job.ranges);
+    free(workers);
+    free(threads);
+
+    return atomic_load(&job.status);
+}
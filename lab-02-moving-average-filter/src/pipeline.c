@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "pipeline.h"
+#include "spsc_queue.h"
+#include "stream_filter.h"
+#include "io.h"
+#include "error_codes.h"
+#include "stats.h"
+
+// The taps check below only has to look at the first block
+_Static_assert(PIPELINE_BLOCK_SIZE >= TAPS, "A block must hold at least TAPS samples");
+
+#define WRITE_BUFFER_SIZE (1 << 20) // stdio buffer of the writer thread
+
+typedef struct
+{
+    int64_t timestamps[PIPELINE_BLOCK_SIZE];
+    float values[PIPELINE_BLOCK_SIZE];
+    int count;
+    bool last;  // No more blocks follow
+    int status; // Error from an earlier stage; the block then carries no data
+} PipelineBlock;
+
+typedef struct
+{
+    const char *input_filename;
+    const char *output_filename;
+    FilterType filter_type;
+    float percentile;
+
+    SpscQueue free_blocks; // writer -> parser, empty blocks for reuse
+    SpscQueue parsed;      // parser -> filter
+    SpscQueue filtered;    // filter -> writer
+
+    atomic_bool stop; // A stage could not start: the others stop waiting for blocks
+    int status;       // Result of the pipeline, set by the writer
+} Pipeline;
+
+// Stage 1: parse CSV rows into blocks
+static void *parser_thread(void *argument)
+{
+    Pipeline *pipeline = argument;
+    CsvReader reader;
+    int result = csv_reader_open(&reader, pipeline->input_filename);
+
+    bool done = false;
+    while (!done)
+    {
+        PipelineBlock *block = spsc_queue_pop_until(&pipeline->free_blocks, &pipeline->stop);
+        if (block == NULL)
+        {
+            break;
+        }
+        block->count = 0;
+        block->status = result;
+
+        if (result == SUCCESS)
+        {
+            uint64_t start = stats_start();
+            while (block->count < PIPELINE_BLOCK_SIZE &&
+                   csv_reader_next(&reader, &block->timestamps[block->count], &block->values[block->count]))
+            {
+                block->count++;
+            }
+            stats_stop(STAGE_READ, start);
+        }
+
+        done = (result != SUCCESS) || block->count < PIPELINE_BLOCK_SIZE;
+        block->last = done;
+        spsc_queue_push_wait(&pipeline->parsed, block);
+    }
+
+    if (result == SUCCESS)
+    {
+        csv_reader_close(&reader);
+    }
+    return NULL;
+}
+
+// The batch filters reject inputs shorter than the window before doing any
+// work. Only the first block can decide that, since every block but the last
+// one is full and a full block is longer than TAPS.
+static int check_length(const Pipeline *pipeline, int num_samples)
+{
+    if (num_samples == 0)
+    {
+        return FILE_HAS_NO_CONTENT;
+    }
+
+    if (TAPS > num_samples)
+    {
+        fprintf(stderr, "Error: Number of taps (%d) cannot exceed number of samples (%d).\n", TAPS, num_samples);
+        return (pipeline->filter_type == LOW_PASS) ? INVALID_TAPS_ERROR : TAPS_EXCEEDS_SAMPLES_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+// Stage 2: filter each block in place, keeping the filter state across blocks
+static void *filter_thread(void *argument)
+{
+    Pipeline *pipeline = argument;
+    StreamFilter *filter = NULL;
+    int result;
+
+    if (pipeline->filter_type == PERCENTILE)
+    {
+        result = stream_filter_create_percentile(&filter, TAPS, pipeline->percentile);
+    }
+    else
+    {
+        result = stream_filter_create(&filter, pipeline->filter_type, TAPS);
+    }
+
+    bool first = true;
+    bool done = false;
+    while (!done)
+    {
+        PipelineBlock *block = spsc_queue_pop_until(&pipeline->parsed, &pipeline->stop);
+        if (block == NULL)
+        {
+            break;
+        }
+        done = block->last;
+
+        if (block->status == SUCCESS && first && block->last)
+        {
+            result = check_length(pipeline, block->count);
+        }
+        first = false;
+
+        if (block->status == SUCCESS && result != SUCCESS)
+        {
+            block->status = result;
+        }
+
+        if (block->status == SUCCESS)
+        {
+            uint64_t start = stats_start();
+            block->status = stream_filter_push_block(filter, block->values, block->values, block->count);
+            stats_stop(STAGE_FILTER, start);
+            stats_add_samples(block->count);
+            result = block->status; // The window is out of step: fail the blocks that follow too
+        }
+
+        spsc_queue_push_wait(&pipeline->filtered, block);
+    }
+
+    stream_filter_destroy(filter);
+    return NULL;
+}
+
+// Stage 3: format the rows and write them out, then recycle the block
+static void *writer_thread(void *argument)
+{
+    Pipeline *pipeline = argument;
+    const char *filter_name = filter_type_name(pipeline->filter_type);
+    FILE *file = NULL;
+    char *buffer = malloc(WRITE_BUFFER_SIZE);
+    int result = SUCCESS;
+
+    bool done = false;
+    while (!done)
+    {
+        PipelineBlock *block = spsc_queue_pop_until(&pipeline->filtered, &pipeline->stop);
+        if (block == NULL)
+        {
+            break;
+        }
+        done = block->last;
+
+        if (result == SUCCESS && block->status != SUCCESS)
+        {
+            result = block->status;
+        }
+
+        // The file is only created once there is something valid to write,
+        // like the sequential mode which fails before opening it
+        if (result == SUCCESS && file == NULL)
+        {
+            file = fopen(pipeline->output_filename, "w");
+            if (file == NULL)
+            {
+                perror("Error opening file for writing");
+                result = FILE_WRITE_ERROR;
+            }
+            else
+            {
+                if (buffer != NULL)
+                {
+                    setvbuf(file, buffer, _IOFBF, WRITE_BUFFER_SIZE);
+                }
+                write_csv_header(file);
+            }
+        }
+
+        if (result == SUCCESS)
+        {
+            uint64_t start = stats_start();
+            for (int i = 0; i < block->count; i++)
+            {
+                write_csv_row(file, filter_name, block->timestamps[i], block->values[i]);
+            }
+            stats_stop(STAGE_WRITE, start);
+        }
+
+        // Keep consuming after an error so the other stages can finish
+        spsc_queue_push_wait(&pipeline->free_blocks, block);
+    }
+
+    stats_add_file_bytes(file, true);
+    if (file != NULL && fclose(file) != 0 && result == SUCCESS)
+    {
+        result = FILE_WRITE_ERROR;
+    }
+    free(buffer);
+
+    pipeline->status = result;
+    return NULL;
+}
+
+int run_pipeline(const char *input_filename, const char *output_filename, FilterType filter_type, float percentile)
+{
+    if (input_filename == NULL || output_filename == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    Pipeline pipeline = {
+        .input_filename = input_filename,
+        .output_filename = output_filename,
+        .filter_type = filter_type,
+        .percentile = percentile,
+        .status = SUCCESS,
+    };
+    atomic_init(&pipeline.stop, false);
+
+    PipelineBlock *blocks = malloc(PIPELINE_NUM_BLOCKS * sizeof(PipelineBlock));
+    if (blocks == NULL ||
+        spsc_queue_init(&pipeline.free_blocks, PIPELINE_NUM_BLOCKS) != SUCCESS ||
+        spsc_queue_init(&pipeline.parsed, PIPELINE_NUM_BLOCKS) != SUCCESS ||
+        spsc_queue_init(&pipeline.filtered, PIPELINE_NUM_BLOCKS) != SUCCESS)
+    {
+        fprintf(stderr, "Error: Failed to allocate the pipeline buffers.\n");
+        free(blocks);
+        spsc_queue_destroy(&pipeline.free_blocks);
+        spsc_queue_destroy(&pipeline.parsed);
+        spsc_queue_destroy(&pipeline.filtered);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    // All sample data of the run lives in these blocks
+    stats_buffer_usage(PIPELINE_NUM_BLOCKS * sizeof(PipelineBlock));
+
+    // All blocks start out empty; this happens before the threads exist
+    for (int i = 0; i < PIPELINE_NUM_BLOCKS; i++)
+    {
+        spsc_queue_push(&pipeline.free_blocks, &blocks[i]);
+    }
+
+    pthread_t threads[3];
+    void *(*stages[3])(void *) = {parser_thread, filter_thread, writer_thread};
+    int started = 0;
+    for (; started < 3; started++)
+    {
+        if (pthread_create(&threads[started], NULL, stages[started], &pipeline) != 0)
+        {
+            break;
+        }
+    }
+
+    // A stage that could not start would leave the others waiting forever
+    if (started < 3)
+    {
+        fprintf(stderr, "Error: Failed to start the pipeline threads.\n");
+        atomic_store_explicit(&pipeline.stop, true, memory_order_release);
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    if (started < 3)
+    {
+        pipeline.status = THREAD_START_ERROR;
+    }
+
+    spsc_queue_destroy(&pipeline.free_blocks);
+    spsc_queue_destroy(&pipeline.parsed);
+    spsc_queue_destroy(&pipeline.filtered);
+    free(blocks);
+
+    return pipeline.status;
+}
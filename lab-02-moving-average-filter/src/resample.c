@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "resample.h"
+#include "ring_buffer.h"
+#include "error_codes.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * Polyphase rational resampling
+ * -----------------------------
+ * Resampling by L/M means: insert L-1 zeros between input samples, low-pass
+ * filter the result with h[] to remove the images/aliases, then keep every
+ * M-th sample. Done literally that wastes almost all of the work: most of the
+ * products are with inserted zeros and most of the outputs are thrown away.
+ *
+ * Output number m sits at index n = m * M of the upsampled signal. Only the
+ * taps h[p], h[p + L], h[p + 2L], ... with p = n mod L line up with real input
+ * samples, so the output is a short dot product with one "phase" of h[]:
+ *
+ *   y[m] = sum_t h[p + t * L] * x[n / L - t]
+ *
+ * For a plain decimator (L = 1) this evaluates the anti-aliasing FIR only at
+ * the samples that are kept, which cuts the multiplications by a factor of M
+ * compared with filtering every sample and dropping the rest afterwards.
+ *
+ * The prototype filter is symmetric, so it delays the signal by half its
+ * length. That delay is compensated by starting the output index 'delay'
+ * samples late and flushing the tail at the end, which keeps output m aligned
+ * with input time m * M / L. The history is primed with the first sample (and
+ * the tail padded with the last one) so the ends do not ramp from zero.
+ */
+
+struct Resampler
+{
+    int interpolation;    // L
+    int decimation;       // M
+    int phase_length;     // Taps per polyphase branch
+    float *coefficients;  // L branches of 'phase_length' taps, branch-major
+    RingBuffer history;   // Most recent input samples
+    long long next_index; // Upsampled index of the next output (m * M)
+    long long input_base; // Upsampled index of the next input sample (q * L)
+    long long delay;      // Group delay of the prototype filter, in upsampled samples
+};
+
+static int greatest_common_divisor(int a, int b)
+{
+    while (b != 0)
+    {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Windowed-sinc low-pass prototype, split into L polyphase branches.
+// The cutoff sits at the lower of the two Nyquist frequencies and the gain is
+// L so that every branch has (close to) unity DC gain.
+static void design_polyphase(Resampler *resampler)
+{
+    int L = resampler->interpolation;
+    int ratio = (L > resampler->decimation) ? L : resampler->decimation;
+    int length = resampler->phase_length * L;
+    double cutoff = 0.5 / ratio; // In cycles per upsampled sample
+    double centre = (length - 1) / 2.0;
+    double sum = 0.0;
+
+    for (int k = 0; k < length; k++)
+    {
+        double x = k - centre;
+        double sinc = (x == 0.0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        double window = 0.54 - 0.46 * cos(2.0 * M_PI * k / (length - 1)); // Hamming
+        double tap = sinc * window;
+
+        // Tap k belongs to branch k % L at position k / L
+        resampler->coefficients[(k % L) * resampler->phase_length + k / L] = (float)tap;
+        sum += tap;
+    }
+
+    float scale = (float)(L / sum);
+    for (int k = 0; k < length; k++)
+    {
+        resampler->coefficients[k] *= scale;
+    }
+}
+
+int resampler_create(Resampler **resampler, int interpolation, int decimation)
+{
+    if (resampler == NULL)
+    {
+        fprintf(stderr, "Error: Resampler handle is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    *resampler = NULL;
+
+    if (interpolation <= 0 || decimation <= 0 ||
+        interpolation > MAX_RESAMPLE_FACTOR || decimation > MAX_RESAMPLE_FACTOR)
+    {
+        fprintf(stderr, "Error: Resampling factors must be between 1 and %d.\n", MAX_RESAMPLE_FACTOR);
+        return INVALID_ARGUMENT;
+    }
+
+    // 2/4 is the same rate change as 1/2, just with a longer filter
+    int divisor = greatest_common_divisor(interpolation, decimation);
+    interpolation /= divisor;
+    decimation /= divisor;
+
+    Resampler *new_resampler = calloc(1, sizeof(*new_resampler));
+    if (new_resampler == NULL)
+    {
+        fprintf(stderr, "Error: Failed to allocate the resampler.\n");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    int ratio = (interpolation > decimation) ? interpolation : decimation;
+    new_resampler->interpolation = interpolation;
+    new_resampler->decimation = decimation;
+    new_resampler->phase_length = (RESAMPLE_TAPS_PER_RATIO * ratio + interpolation - 1) / interpolation;
+    new_resampler->coefficients = malloc((size_t)new_resampler->phase_length * interpolation * sizeof(float));
+
+    if (new_resampler->coefficients == NULL ||
+        ring_init(&new_resampler->history, new_resampler->phase_length) != SUCCESS)
+    {
+        fprintf(stderr, "Error: Failed to allocate the resampler filter.\n");
+        resampler_destroy(new_resampler);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    design_polyphase(new_resampler);
+    new_resampler->delay = ((long long)new_resampler->phase_length * interpolation - 1) / 2;
+    new_resampler->next_index = new_resampler->delay;
+
+    *resampler = new_resampler;
+    return SUCCESS;
+}
+
+// Push one input sample and compute the outputs that become available.
+// Returns the number of outputs written, or -1 if 'output' ran out of space.
+static int resampler_push(Resampler *resampler, float sample, float *output, int space)
+{
+    int L = resampler->interpolation;
+    int produced = 0;
+
+    if (resampler->history.count == 0)
+    {
+        // Steady-state start: behave as if the first sample had always been there
+        for (int t = 0; t < resampler->phase_length; t++)
+        {
+            ring_push(&resampler->history, sample, resampler->phase_length);
+        }
+    }
+    else
+    {
+        ring_push(&resampler->history, sample, resampler->phase_length);
+    }
+
+    // Every output whose upsampled index falls between this input sample
+    // and the next one is computed from the same history
+    long long next_base = resampler->input_base + L;
+    while (resampler->next_index < next_base)
+    {
+        if (produced == space)
+        {
+            return -1;
+        }
+
+        int phase = (int)(resampler->next_index - resampler->input_base);
+        const float *branch = resampler->coefficients + (size_t)phase * resampler->phase_length;
+
+        float sum = 0.0f;
+        for (int t = 0; t < resampler->phase_length; t++)
+        {
+            sum += branch[t] * ring_get(&resampler->history, t);
+        }
+
+        output[produced++] = sum;
+        resampler->next_index += resampler->decimation;
+    }
+    resampler->input_base = next_base;
+
+    return produced;
+}
+
+int resampler_process(Resampler *resampler, const float *input, int num_input,
+                      float *output, int max_output, int *num_output)
+{
+    if (resampler == NULL || input == NULL || output == NULL || num_output == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_input < 0 || max_output < 0)
+    {
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    int produced = 0;
+    for (int i = 0; i < num_input; i++)
+    {
+        int count = resampler_push(resampler, input[i], output + produced, max_output - produced);
+        if (count < 0)
+        {
+            *num_output = produced;
+            return INVALID_NUM_SAMPLES_ERROR; // Output buffer too small
+        }
+        produced += count;
+    }
+
+    *num_output = produced;
+    return SUCCESS;
+}
+
+int resampler_flush(Resampler *resampler, float *output, int max_output, int *num_output)
+{
+    if (resampler == NULL || output == NULL || num_output == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    int produced = 0;
+
+    // Nothing was pushed, so there is no tail to produce
+    if (resampler->history.count > 0)
+    {
+        // Outputs are due up to the end of the real input, but each one is only
+        // computed 'delay' upsampled samples after its own position
+        long long input_end = resampler->input_base;
+        float last = ring_get(&resampler->history, 0);
+
+        while (resampler->next_index - resampler->delay < input_end)
+        {
+            int count = resampler_push(resampler, last, output + produced, max_output - produced);
+            if (count < 0)
+            {
+                *num_output = produced;
+                return INVALID_NUM_SAMPLES_ERROR;
+            }
+            produced += count;
+        }
+
+        // The padding pushes may have overshot the end of the real input
+        while (produced > 0 &&
+               resampler->next_index - resampler->decimation - resampler->delay >= input_end)
+        {
+            resampler->next_index -= resampler->decimation;
+            produced--;
+        }
+    }
+
+    *num_output = produced;
+    return SUCCESS;
+}
+
+int resampler_output_length(int num_input, int interpolation, int decimation)
+{
+    if (num_input <= 0 || interpolation <= 0 || decimation <= 0)
+    {
+        return 0;
+    }
+
+    // Outputs m with m * M < num_input * L
+    return (int)(((long long)num_input * interpolation + decimation - 1) / decimation);
+}
+
+void resampler_reset(Resampler *resampler)
+{
+    if (resampler == NULL)
+    {
+        return;
+    }
+
+    ring_clear(&resampler->history);
+    resampler->next_index = resampler->delay;
+    resampler->input_base = 0;
+}
+
+void resampler_destroy(Resampler *resampler)
+{
+    if (resampler == NULL)
+    {
+        return;
+    }
+
+    ring_free(&resampler->history);
+    free(resampler->coefficients);
+    free(resampler);
+}
+
+int resample_filter(const float *input, int num_samples, float *output, int max_output,
+                    int interpolation, int decimation, int *num_output)
+{
+    if (input == NULL || output == NULL || num_output == NULL)
+    {
+        fprintf(stderr, "Error: Input or output array is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_samples <= 0)
+    {
+        fprintf(stderr, "Error: Number of samples must be greater than 0.\n");
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    Resampler *resampler;
+    int result = resampler_create(&resampler, interpolation, decimation);
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    int num_tail = 0;
+    result = resampler_process(resampler, input, num_samples, output, max_output, num_output);
+    if (result == SUCCESS)
+    {
+        result = resampler_flush(resampler, output + *num_output, max_output - *num_output, &num_tail);
+        *num_output += num_tail;
+    }
+
+    if (result == INVALID_NUM_SAMPLES_ERROR)
+    {
+        fprintf(stderr, "Error: Output buffer is too small for the resampled data.\n");
+    }
+
+    resampler_destroy(resampler);
+    return result;
+}
+
+int decimate_filter(const float *input, int num_samples, float *output, int max_output,
+                    int factor, int *num_output)
+{
+    return resample_filter(input, num_samples, output, max_output, 1, factor, num_output);
+}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "skiplist.h"
+#include "error_codes.h"
+
+#define NIL -1 // End of a level
+
+/*
+ * Indexable skiplist
+ * -----------------------------
+ * A skiplist keeps the values sorted in a linked list with extra "express"
+ * lanes on top: level 0 links every node, level 1 about every second node,
+ * level 2 about every fourth, and so on. A search starts on the highest lane
+ * and drops down one level whenever the next node would overshoot, which
+ * visits O(log n) nodes on average.
+ *
+ * Storing the width of every link (how many level-0 steps it covers) makes
+ * the list indexable: to find the k-th value, follow links while their width
+ * fits into the remaining k. Insert and remove update the widths of the links
+ * that pass over the changed node.
+ *
+ * Nodes are referenced by index into a preallocated pool; index 0 is the
+ * head, free nodes are kept on a stack.
+ */
+
+typedef struct
+{
+    float value;
+    int levels;                      // Number of lanes this node is part of
+    int next[SKIPLIST_MAX_LEVEL];    // Following node on each lane
+    int width[SKIPLIST_MAX_LEVEL];   // Level-0 steps covered by each link
+} SkiplistNode;
+
+struct IndexableSkiplist
+{
+    SkiplistNode *nodes; // nodes[0] is the head
+    int *free_nodes;     // Stack of unused node indices
+    int free_count;
+    int capacity;
+    int max_level;       // Lanes in use, about log2(capacity) + 1
+    int size;
+    unsigned random_state;
+};
+
+// xorshift32, enough randomness for choosing node heights
+static unsigned next_random(IndexableSkiplist *list)
+{
+    unsigned x = list->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    list->random_state = x;
+    return x;
+}
+
+// Each additional lane with probability 1/2
+static int random_levels(IndexableSkiplist *list)
+{
+    int levels = 1;
+    unsigned bits = next_random(list);
+    while (levels < list->max_level && (bits & 1u))
+    {
+        levels++;
+        bits >>= 1;
+    }
+    return levels;
+}
+
+int skiplist_create(IndexableSkiplist **list, int capacity)
+{
+    if (list == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    *list = NULL;
+
+    if (capacity <= 0)
+    {
+        return INVALID_TAPS_ERROR;
+    }
+
+    IndexableSkiplist *new_list = calloc(1, sizeof(*new_list));
+    if (new_list == NULL)
+    {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    new_list->nodes = malloc(((size_t)capacity + 1) * sizeof(SkiplistNode));
+    new_list->free_nodes = malloc((size_t)capacity * sizeof(int));
+    if (new_list->nodes == NULL || new_list->free_nodes == NULL)
+    {
+        skiplist_destroy(new_list);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    new_list->capacity = capacity;
+    new_list->max_level = 1;
+    while (new_list->max_level < SKIPLIST_MAX_LEVEL && (1 << (new_list->max_level - 1)) < capacity)
+    {
+        new_list->max_level++;
+    }
+    new_list->random_state = 0x9E3779B9u;
+
+    skiplist_clear(new_list);
+
+    *list = new_list;
+    return SUCCESS;
+}
+
+void skiplist_clear(IndexableSkiplist *list)
+{
+    if (list == NULL)
+    {
+        return;
+    }
+
+    SkiplistNode *head = &list->nodes[0];
+    head->levels = list->max_level;
+    for (int level = 0; level < list->max_level; level++)
+    {
+        head->next[level] = NIL;
+        head->width[level] = 1;
+    }
+
+    // Hand the nodes out in index order, which keeps a fresh list compact in memory
+    list->free_count = list->capacity;
+    for (int i = 0; i < list->capacity; i++)
+    {
+        list->free_nodes[i] = list->capacity - i;
+    }
+
+    list->size = 0;
+}
+
+int skiplist_insert(IndexableSkiplist *list, float value)
+{
+    if (list->free_count == 0)
+    {
+        return INVALID_NUM_SAMPLES_ERROR; // Pool exhausted
+    }
+
+    SkiplistNode *nodes = list->nodes;
+    int chain[SKIPLIST_MAX_LEVEL];    // Last node before the insert position on each lane
+    int position[SKIPLIST_MAX_LEVEL]; // Level-0 index of that node
+
+    int current = 0;
+    int steps = 0;
+    for (int level = list->max_level - 1; level >= 0; level--)
+    {
+        int next = nodes[current].next[level];
+        while (next != NIL && nodes[next].value <= value)
+        {
+            steps += nodes[current].width[level];
+            current = next;
+            next = nodes[current].next[level];
+        }
+        chain[level] = current;
+        position[level] = steps;
+    }
+
+    int index = list->free_nodes[--list->free_count];
+    SkiplistNode *node = &nodes[index];
+    node->value = value;
+    node->levels = random_levels(list);
+
+    // Split the links that now pass through the new node
+    for (int level = 0; level < node->levels; level++)
+    {
+        SkiplistNode *previous = &nodes[chain[level]];
+        int skipped = steps - position[level]; // Level-0 steps from chain[level] to the new node's predecessor
+
+        node->next[level] = previous->next[level];
+        node->width[level] = previous->width[level] - skipped;
+        previous->next[level] = index;
+        previous->width[level] = skipped + 1;
+    }
+
+    // Links on higher lanes jump over the new node and get one step longer
+    for (int level = node->levels; level < list->max_level; level++)
+    {
+        nodes[chain[level]].width[level]++;
+    }
+
+    list->size++;
+    return SUCCESS;
+}
+
+int skiplist_remove(IndexableSkiplist *list, float value)
+{
+    SkiplistNode *nodes = list->nodes;
+    int chain[SKIPLIST_MAX_LEVEL];
+
+    int current = 0;
+    for (int level = list->max_level - 1; level >= 0; level--)
+    {
+        int next = nodes[current].next[level];
+        while (next != NIL && nodes[next].value < value)
+        {
+            current = next;
+            next = nodes[current].next[level];
+        }
+        chain[level] = current;
+    }
+
+    int index = nodes[chain[0]].next[0];
+    if (index == NIL || nodes[index].value != value)
+    {
+        return INVALID_ARGUMENT; // Value is not in the list
+    }
+
+    SkiplistNode *node = &nodes[index];
+
+    // Merge the links around the removed node
+    for (int level = 0; level < node->levels; level++)
+    {
+        SkiplistNode *previous = &nodes[chain[level]];
+        previous->width[level] += node->width[level] - 1;
+        previous->next[level] = node->next[level];
+    }
+
+    for (int level = node->levels; level < list->max_level; level++)
+    {
+        nodes[chain[level]].width[level]--;
+    }
+
+    list->free_nodes[list->free_count++] = index;
+    list->size--;
+    return SUCCESS;
+}
+
+float skiplist_get(const IndexableSkiplist *list, int rank)
+{
+    const SkiplistNode *nodes = list->nodes;
+    int remaining = rank + 1; // Level-0 steps from the head
+    int current = 0;
+
+    for (int level = list->max_level - 1; level >= 0; level--)
+    {
+        while (nodes[current].next[level] != NIL && nodes[current].width[level] <= remaining)
+        {
+            remaining -= nodes[current].width[level];
+            current = nodes[current].next[level];
+        }
+    }
+
+    return nodes[current].value;
+}
+
+int skiplist_size(const IndexableSkiplist *list)
+{
+    return list->size;
+}
+
+void skiplist_destroy(IndexableSkiplist *list)
+{
+    if (list == NULL)
+    {
+        return;
+    }
+
+    free(list->nodes);
+    free(list->free_nodes);
+    free(list);
+}
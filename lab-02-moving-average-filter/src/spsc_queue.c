@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <sched.h>
+#include "spsc_queue.h"
+#include "error_codes.h"
+
+#define SPIN_LIMIT 64 // Polls before giving the CPU away while waiting
+
+int spsc_queue_init(SpscQueue *queue, size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    queue->slots = calloc(size, sizeof(void *));
+    if (queue->slots == NULL)
+    {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    queue->mask = size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return SUCCESS;
+}
+
+bool spsc_queue_push(SpscQueue *queue, void *item)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head > queue->mask)
+    {
+        return false; // Full
+    }
+
+    queue->slots[tail & queue->mask] = item;
+
+    // Release: the slot contents become visible before the new tail
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_queue_pop(SpscQueue *queue, void **item)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail)
+    {
+        return false; // Empty
+    }
+
+    *item = queue->slots[head & queue->mask];
+
+    // Release: the slot is read before the producer may reuse it
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Waiting spins briefly (the other side is usually just about to finish a
+// block) and then yields, so a single-core machine still makes progress
+void spsc_queue_push_wait(SpscQueue *queue, void *item)
+{
+    for (int spins = 0; !spsc_queue_push(queue, item); spins++)
+    {
+        if (spins >= SPIN_LIMIT)
+        {
+            sched_yield();
+        }
+    }
+}
+
+void *spsc_queue_pop_wait(SpscQueue *queue)
+{
+    return spsc_queue_pop_until(queue, NULL);
+}
+
+// The flag is only looked at while the queue is empty, so items that are
+// already queued are still handed out after it is set
+void *spsc_queue_pop_until(SpscQueue *queue, atomic_bool *stop)
+{
+    void *item;
+    for (int spins = 0; !spsc_queue_pop(queue, &item); spins++)
+    {
+        if (stop != NULL && atomic_load_explicit(stop, memory_order_acquire))
+        {
+            return NULL;
+        }
+        if (spins >= SPIN_LIMIT)
+        {
+            sched_yield();
+        }
+    }
+    return item;
+}
+
+size_t spsc_queue_size(SpscQueue *queue)
+{
+    return atomic_load_explicit(&queue->tail, memory_order_acquire) -
+           atomic_load_explicit(&queue->head, memory_order_acquire);
+}
+
+void spsc_queue_destroy(SpscQueue *queue)
+{
+    free(queue->slots);
+    queue->slots = NULL;
+}
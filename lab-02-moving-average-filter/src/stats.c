@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include "stats.h"
+
+FilterStats filter_stats;
+
+// JSON keys of the stages, in StatsStage order
+static const char *stage_names[NUM_STAGES] = {
+    "read", "filter", "fixed_point", "decimate", "write", "aggregate", "export", "total",
+};
+
+void stats_add_file_bytes(FILE *file, bool output)
+{
+    if (!filter_stats.enabled || file == NULL)
+    {
+        return;
+    }
+
+    long position = ftell(file);
+    if (position > 0)
+    {
+        if (output)
+        {
+            filter_stats.bytes_out += (uint64_t)position;
+        }
+        else
+        {
+            filter_stats.bytes_in += (uint64_t)position;
+        }
+    }
+}
+
+void stats_print_json(FILE *file)
+{
+    fprintf(file, "{\n  \"stages\": {");
+
+    // Only the stages that ran in this mode
+    const char *separator = "";
+    for (int i = 0; i < NUM_STAGES; i++)
+    {
+        if (filter_stats.stage_calls[i] > 0)
+        {
+            fprintf(file, "%s\n    \"%s\": {\"seconds\": %.6f, \"calls\": %ld}", separator, stage_names[i],
+                    filter_stats.stage_ns[i] * 1e-9, filter_stats.stage_calls[i]);
+            separator = ",";
+        }
+    }
+
+    fprintf(file, "\n  },\n");
+    fprintf(file, "  \"rows_read\": %ld,\n", filter_stats.rows_read);
+    fprintf(file, "  \"rows_rejected\": %ld,\n", filter_stats.rows_rejected);
+    fprintf(file, "  \"bytes_in\": %llu,\n", (unsigned long long)filter_stats.bytes_in);
+    fprintf(file, "  \"bytes_out\": %llu,\n", (unsigned long long)filter_stats.bytes_out);
+    fprintf(file, "  \"samples_filtered\": %ld,\n", filter_stats.samples_filtered);
+    fprintf(file, "  \"peak_buffer_bytes\": %zu\n", filter_stats.peak_buffer_bytes);
+    fprintf(file, "}\n");
+}
@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "filter.h"
+#include "stream_filter.h"
+#include "ring_buffer.h"
+#include "skiplist.h"
+#include "error_codes.h"
+
+struct StreamFilter
+{
+    FilterType filter_type;
+    int taps;          // Moving average window size
+    RingBuffer window; // Raw input history for the moving average
+    RingBuffer fir;    // Moving average history for the low-pass FIR stage
+    IndexableSkiplist *order; // Window contents in sorted order (median/percentile)
+    float percentile;         // 0-100, 50 for the median
+};
+
+// One moving average step.
+// The window is summed newest-to-oldest, in the same order the original batch
+// loop used, so the results are bit-identical to it and do not depend on how
+// long the filter has been running (no drift from a running sum).
+static inline float moving_average_step(StreamFilter *filter, float sample)
+{
+    ring_push(&filter->window, sample, filter->taps);
+
+    float sum = 0;
+    for (int j = 0; j < filter->window.count; j++)
+    {
+        sum += ring_get(&filter->window, j);
+    }
+
+    return sum / filter->window.count;
+}
+
+// One FIR step over the moving average output.
+// Taps that would reach before the first sample are skipped, which matches
+// the zero initial state of the batch implementation.
+static inline float low_pass_step(StreamFilter *filter, float sample)
+{
+    ring_push(&filter->fir, moving_average_step(filter, sample), LOW_FILTER_TAP_NUM);
+
+    float output = 0.0f;
+    for (int j = 0; j < filter->fir.count; j++)
+    {
+        output += filter_taps[j] * ring_get(&filter->fir, j);
+    }
+
+    return output;
+}
+
+// One median/percentile step.
+// The sorted view of the window is updated with one O(log w) insert and one
+// O(log w) remove; the percentile is then read by rank. Between two ranks the
+// value is interpolated linearly, so an even-sized median is the mean of the
+// two middle values. A NaN has no rank, so it is rejected before it can enter
+// the window; the sorted view would otherwise never find it again to remove it.
+static inline int percentile_step(StreamFilter *filter, float sample, float *output)
+{
+    if (isnan(sample))
+    {
+        fprintf(stderr, "Error: NaN sample in a median/percentile filter.\n");
+        return INVALID_ARGUMENT;
+    }
+
+    int result = SUCCESS;
+    if (filter->window.count == filter->taps)
+    {
+        // The sample about to be overwritten leaves the window
+        result = skiplist_remove(filter->order, ring_get(&filter->window, filter->taps - 1));
+    }
+    if (result == SUCCESS)
+    {
+        ring_push(&filter->window, sample, filter->taps);
+        result = skiplist_insert(filter->order, sample);
+    }
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Median/percentile window out of step (Error code: %d).\n", result);
+        return result;
+    }
+
+    float position = filter->percentile / 100.0f * (filter->window.count - 1);
+    int lower = (int)position;
+    float fraction = position - lower;
+    float value = skiplist_get(filter->order, lower);
+
+    if (fraction > 0.0f && lower + 1 < filter->window.count)
+    {
+        value += fraction * (skiplist_get(filter->order, lower + 1) - value);
+    }
+
+    *output = value;
+    return SUCCESS;
+}
+
+int stream_filter_create(StreamFilter **filter, FilterType filter_type, int taps)
+{
+    if (filter == NULL)
+    {
+        fprintf(stderr, "Error: Filter handle is NULL.\n");
+        return NULL_POINTER_ERROR;
+    }
+
+    *filter = NULL;
+
+    if (taps <= 0)
+    {
+        fprintf(stderr, "Error: Number of taps must be greater than 0.\n");
+        return INVALID_TAPS_ERROR;
+    }
+
+    if (filter_type != MOVING_AVERAGE && filter_type != LOW_PASS && filter_type != MEDIAN &&
+        filter_type != PERCENTILE)
+    {
+        fprintf(stderr, "Error: Unknown filter type (%d).\n", filter_type);
+        return UNKNOWN_FILTER_TYPE;
+    }
+
+    StreamFilter *new_filter = calloc(1, sizeof(*new_filter));
+    if (new_filter == NULL)
+    {
+        fprintf(stderr, "Error: Failed to allocate the filter object.\n");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    new_filter->filter_type = filter_type;
+    new_filter->taps = taps;
+    new_filter->percentile = (filter_type == PERCENTILE) ? DEFAULT_PERCENTILE : 50.0f;
+
+    int result = ring_init(&new_filter->window, taps);
+    if (result == SUCCESS && filter_type == LOW_PASS)
+    {
+        result = ring_init(&new_filter->fir, LOW_FILTER_TAP_NUM);
+    }
+    if (result == SUCCESS && (filter_type == MEDIAN || filter_type == PERCENTILE))
+    {
+        result = skiplist_create(&new_filter->order, taps);
+    }
+
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Failed to allocate the filter history.\n");
+        stream_filter_destroy(new_filter);
+        return result;
+    }
+
+    *filter = new_filter;
+    return SUCCESS;
+}
+
+int stream_filter_create_percentile(StreamFilter **filter, int taps, float percentile)
+{
+    if (percentile < 0.0f || percentile > 100.0f)
+    {
+        fprintf(stderr, "Error: Percentile must be between 0 and 100.\n");
+        return INVALID_ARGUMENT;
+    }
+
+    int result = stream_filter_create(filter, PERCENTILE, taps);
+    if (result == SUCCESS)
+    {
+        (*filter)->percentile = percentile;
+    }
+
+    return result;
+}
+
+int stream_filter_push(StreamFilter *filter, float sample, float *output)
+{
+    if (filter == NULL || output == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    if (filter->filter_type == LOW_PASS)
+    {
+        *output = low_pass_step(filter, sample);
+    }
+    else if (filter->filter_type == MEDIAN || filter->filter_type == PERCENTILE)
+    {
+        return percentile_step(filter, sample, output);
+    }
+    else
+    {
+        *output = moving_average_step(filter, sample);
+    }
+
+    return SUCCESS;
+}
+
+int stream_filter_push_block(StreamFilter *filter, const float *input, float *output, int num_samples)
+{
+    if (filter == NULL || input == NULL || output == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    if (num_samples < 0)
+    {
+        return INVALID_NUM_SAMPLES_ERROR;
+    }
+
+    // Branch on the filter type once per block rather than once per sample
+    if (filter->filter_type == LOW_PASS)
+    {
+        for (int i = 0; i < num_samples; i++)
+        {
+            output[i] = low_pass_step(filter, input[i]);
+        }
+    }
+    else if (filter->filter_type == MEDIAN || filter->filter_type == PERCENTILE)
+    {
+        for (int i = 0; i < num_samples; i++)
+        {
+            int result = percentile_step(filter, input[i], &output[i]);
+            if (result != SUCCESS)
+            {
+                return result;
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < num_samples; i++)
+        {
+            output[i] = moving_average_step(filter, input[i]);
+        }
+    }
+
+    return SUCCESS;
+}
+
+void stream_filter_reset(StreamFilter *filter)
+{
+    if (filter == NULL)
+    {
+        return;
+    }
+
+    ring_clear(&filter->window);
+    ring_clear(&filter->fir);
+    skiplist_clear(filter->order);
+}
+
+void stream_filter_destroy(StreamFilter *filter)
+{
+    if (filter == NULL)
+    {
+        return;
+    }
+
+    ring_free(&filter->window);
+    ring_free(&filter->fir);
+    skiplist_destroy(filter->order);
+    free(filter);
+}
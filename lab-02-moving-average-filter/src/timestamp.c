@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include "timestamp.h"
+#include "error_codes.h"
+
+/*
+ * Conversions between calendar dates and a day count.
+ * -----------------------------
+ * These are the branch-free proleptic Gregorian algorithms by Howard Hinnant.
+ * The calendar is split into 400-year "eras" that all have the same length
+ * (146097 days), and each year is shifted to start in March so the leap day
+ * lands at the end of the year. That keeps the conversion to a handful of
+ * integer operations and avoids mktime(), which depends on the local time
+ * zone and is far too slow to call for every line of a large file.
+ */
+int64_t days_from_civil(int64_t year, unsigned month, unsigned day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned year_of_era = (unsigned)(year - era * 400);                                // [0, 399]
+    const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + (int64_t)day_of_era - 719468;
+}
+
+void civil_from_days(int64_t days, int64_t *year, unsigned *month, unsigned *day)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned day_of_era = (unsigned)(days - era * 146097);                                          // [0, 146096]
+    const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365; // [0, 399]
+    const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);   // [0, 365]
+    const unsigned shifted_month = (5 * day_of_year + 2) / 153;                                         // [0, 11]
+
+    *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    *year = (int64_t)year_of_era + era * 400 + (*month <= 2);
+}
+
+// Read exactly 'digits' decimal digits, returns -1 if a non-digit is found
+static int parse_digits(const char *text, int digits)
+{
+    int value = 0;
+    for (int i = 0; i < digits; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return -1;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+// Number of days in a month of the proleptic Gregorian calendar
+static int days_in_month(int year, int month)
+{
+    static const int lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return (month == 2 && leap) ? 29 : lengths[month - 1];
+}
+
+// Parse the ISO 8601 local date-time used by the Open-Meteo data, e.g. "2024-10-13T07:00".
+// Hand-written instead of sscanf/strptime because it runs once per input line.
+int parse_timestamp(const char *text, int64_t *epoch)
+{
+    if (text == NULL || epoch == NULL)
+    {
+        return NULL_POINTER_ERROR;
+    }
+
+    // Fixed layout: YYYY-MM-DDTHH:MM with optional :SS.
+    // Each separator is checked before the next field is read, so a short
+    // string stops at its terminator instead of reading past it.
+    int year = parse_digits(text, 4);
+    if (year < 0 || text[4] != '-')
+    {
+        return INVALID_TIMESTAMP;
+    }
+
+    int month = parse_digits(text + 5, 2);
+    if (month < 1 || month > 12 || text[7] != '-')
+    {
+        return INVALID_TIMESTAMP;
+    }
+
+    int day = parse_digits(text + 8, 2);
+    if (day < 1 || day > days_in_month(year, month) || (text[10] != 'T' && text[10] != ' '))
+    {
+        return INVALID_TIMESTAMP;
+    }
+
+    int hour = parse_digits(text + 11, 2);
+    if (hour < 0 || hour > 23 || text[13] != ':')
+    {
+        return INVALID_TIMESTAMP;
+    }
+
+    int minute = parse_digits(text + 14, 2);
+    if (minute < 0 || minute > 59)
+    {
+        return INVALID_TIMESTAMP;
+    }
+
+    int second = 0;
+    if (text[16] == ':')
+    {
+        second = parse_digits(text + 17, 2);
+        if (second < 0 || second > 59)
+        {
+            return INVALID_TIMESTAMP;
+        }
+    }
+
+    int64_t days = days_from_civil(year, (unsigned)month, (unsigned)day);
+    *epoch = days * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    return SUCCESS;
+}
+
+// Format in the same layout as the input. Seconds are only printed when they
+// are not zero, so hourly data round-trips to exactly the original text.
+void format_timestamp(int64_t epoch, char *buffer, size_t size)
+{
+    int64_t days = epoch / SECONDS_PER_DAY;
+    int64_t seconds = epoch % SECONDS_PER_DAY;
+    if (seconds < 0) // Floor division for dates before 1970
+    {
+        seconds += SECONDS_PER_DAY;
+        days--;
+    }
+
+    int64_t year;
+    unsigned month, day;
+    civil_from_days(days, &year, &month, &day);
+
+    int hour = (int)(seconds / 3600);
+    int minute = (int)(seconds / 60 % 60);
+    int second = (int)(seconds % 60);
+
+    if (second != 0)
+    {
+        snprintf(buffer, size, "%04lld-%02u-%02uT%02d:%02d:%02d", (long long)year, month, day, hour, minute, second);
+    }
+    else
+    {
+        snprintf(buffer, size, "%04lld-%02u-%02uT%02d:%02d", (long long)year, month, day, hour, minute);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#define NS_PER_SECOND 1000000000LL
+#define MAX_RUN_SECONDS 1e9 // Longest run or offset (about 31 years), well within SimTime
+#define MAX_CLOCK_SPEED 1e6 // Fastest scaled clock
+
+// Simulated wall-clock time in nanoseconds since 1970-01-01 UTC
+typedef int64_t SimTime;
+
+// Where the controller's notion of time comes from
+typedef enum
+{
+    CLOCK_MODE_REAL,    // Wall-clock time, phases last as long as configured
+    CLOCK_MODE_SCALED,  // Runs 'speed' times faster than real time
+    CLOCK_MODE_VIRTUAL, // Jumps from event to event without waiting at all
+} ClockMode;
+
+typedef struct
+{
+    ClockMode mode;
+    double speed;      // Simulated seconds per real second (1 in real mode)
+    SimTime start;     // Simulated time when the clock was started
+    SimTime real_start; // CLOCK_MONOTONIC reading at that moment (real and scaled modes)
+    SimTime now;       // Current time of the virtual clock
+} Clock;
+
+int clock_init(Clock *clock, ClockMode mode, double speed, SimTime start); // start < 0: current wall time
+SimTime clock_now(const Clock *clock);                                     // Current simulated time
+void clock_advance(Clock *clock, SimTime time);                            // Virtual mode: jump forward to 'time'
+struct timespec clock_monotonic_deadline(const Clock *clock, SimTime time); // CLOCK_MONOTONIC instant of a simulated time
+void clock_local_time(SimTime time, struct tm *local_time);                 // Reentrant local-time breakdown
+void clock_format(SimTime time, char *buffer, size_t size);                 // "YYYY-MM-DD HH:MM:SS" in local time
+int clock_parse(const char *text, SimTime *time);                           // Inverse of clock_format
+
+#endif
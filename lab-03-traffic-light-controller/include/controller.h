@@ -0,0 +1,125 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "clock.h"
+#include "timer_wheel.h"
+#include "traffic_light.h"
+#include "schedule.h"
+#include "event_queue.h"
+#include "trace_log.h"
+#include "vehicle_queue.h"
+#include "traffic_source.h"
+#include "corridor.h"
+#include "snapshot.h"
+
+#define MAX_CONTROLLER_THREADS 256
+#define MAX_INPUTS 16        // Input sources (files, FIFOs, stdin)
+#define GRID_STAGGER_MS 1000 // Phases started together are spread over this much time
+#define LATENCY_BUCKETS 64   // Power-of-two nanosecond buckets
+#define PEDESTRIAN_WAIT_BUCKETS 301 // One per second, the last for 300 s and more
+
+// Timer and input accounting of one shard
+typedef struct
+{
+    long timers;           // Phase deadlines handled
+    long transitions;      // Of those, the ones that changed the state
+    long presses;          // Button presses handled
+    SimTime total_lateness; // Sum of (handled - deadline), simulated time
+    SimTime max_lateness;
+    long inputs;           // Events taken from the input queue
+    int64_t total_input_latency; // Enqueue to service, real nanoseconds
+    int64_t max_input_latency;
+    long input_latency_histogram[LATENCY_BUCKETS]; // Bucket i: latency below 2^(i+1) ns
+    long vehicles_arrived; // Traffic model (detector replay)
+    long vehicles_served;
+    double vehicle_wait;   // Vehicle-seconds in the queues
+    int max_queue;
+    long active_queues;    // Approaches that had traffic
+    long entered[MAX_APPROACHES]; // Simulated vehicles that entered the model, per approach
+    long stops[MAX_APPROACHES];   // Stops at any light of the model, per approach
+    SimTime green[MAX_APPROACHES]; // Green time of all the model's lights, per approach
+    long pedestrians;      // Simulated pedestrian arrivals
+    long joined;           // Presses while pedestrians were crossing, served at once
+    long resumed;          // Lights restored from the state file
+    long requests_served;  // Pedestrian requests served
+    SimTime total_request_wait; // Request registered to served, simulated time
+    SimTime max_request_wait;
+    long request_wait_histogram[PEDESTRIAN_WAIT_BUCKETS];
+    long requests_deferred; // Made while the light was blinking or off, served in the day mode; not in the waits above
+    SimTime total_deferred_wait;
+} ShardStats;
+
+// A group of intersections owned by one thread: the lights, the timing wheel
+// holding their phase deadlines, the queue of their input events, and the
+// event loop that serves them
+typedef struct
+{
+    Clock clock;              // Own copy, a virtual clock is advanced by its shard
+    TrafficLight *lights;     // Slice of the intersections
+    int num_lights;
+    TimerWheel wheel;
+    EventQueue queue;         // Input for the shard's lights, from any thread
+    int wake_fd;              // eventfd signalled after each enqueue, -1 on a virtual clock
+    atomic_long merged;       // Presses dropped because a request was already pending
+    const Schedule *schedule; // Day modes
+    DayMode mode;             // Current mode of all the shard's lights
+    SimTime mode_end;         // Next boundary of the schedule
+    TrafficLight *button;     // Light that receives the scripted presses, NULL for none
+    TraceRing *log;           // Binary trace ring of the shard's thread, NULL for none
+    const SimTime *presses;   // Scripted presses (virtual clock), sorted
+    int num_presses;
+    const InputEvent *replay; // Detector replay for the shard's lights (virtual clock), sorted
+    int num_replay;
+    VehicleQueue *queues;     // MAX_APPROACHES per light with a traffic model, NULL otherwise
+    TimerWheel source_wheel;  // Next arrival of each simulated traffic source
+    VehicleLink *links;       // Main street between the corridor's lights (traffic model)
+    LightSnapshot *snapshots; // State file records of all the lights, by id, NULL for none
+    int num_links;
+    SimTime end;              // Simulated stop time, -1 to run forever
+    atomic_bool stop;         // Set by stop_shard() to end a loop that runs forever
+    ShardStats stats;
+    int result;               // ErrorCode of the shard's loop
+} ControllerShard;
+
+// What to run
+typedef struct
+{
+    const Clock *clock;
+    const PhasePlan *plan;
+    const Schedule *schedule;
+    int num_lights;
+    int num_threads;
+    SimTime end;              // Simulated stop time, -1 to run forever (real or scaled clock)
+    int trace_id;             // Intersection that is printed and gets a plain 'b', -1 for none
+    const SimTime *presses;   // Scripted presses for 'trace_id' (virtual clock)
+    int num_presses;
+    const int *input_fds;     // Input sources, one reader thread each (real or scaled clock)
+    int num_inputs;
+    const char *log_file;     // Binary trace of every intersection, NULL for none
+    const InputEvent *replay; // Detector events to replay with a queue model (virtual clock), sorted
+    int num_replay;
+    const TrafficDemand *demand; // Random arrivals at every intersection (virtual clock), NULL for none
+    const Corridor *corridor; // Coordinated lights along a main street (its first intersections), NULL for none
+    const char *state_file;   // Saved state to resume from and keep up to date, NULL for none
+} GridConfig;
+
+// The running intersections, as seen by the input threads
+typedef struct
+{
+    TrafficLight *lights;
+    int num_lights;
+    ControllerShard *shards;
+    int num_shards;
+    const Clock *clock;
+    int default_light;        // Target of input lines without an intersection
+} Grid;
+
+int init_shard(ControllerShard *shard, const Clock *clock, const Schedule *schedule, TrafficLight *lights,
+               int num_lights, SimTime end, TraceRing *log, const Snapshot *snapshot); // Start or resume the lights and fill the wheel
+int run_shard(ControllerShard *shard); // Serve the shard's timers and input until 'end'
+int submit_input(Grid *grid, InputType type, int intersection, int value); // Queue an input event (any thread)
+int run_grid(const GridConfig *config); // Many intersections on worker threads
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef CORRIDOR_H
+#define CORRIDOR_H
+
+#include <stdbool.h>
+#include "clock.h"
+#include "phase_plan.h"
+
+#define MAX_CORRIDOR_LENGTH 64 // Intersections along one corridor
+#define MAIN_APPROACH 0        // Main street, towards the higher positions
+#define OPPOSITE_APPROACH 2    // Main street, the other way
+#define OUTBOUND 0             // Band of the vehicles on MAIN_APPROACH
+#define INBOUND 1              // Band of the vehicles on OPPOSITE_APPROACH
+
+// The common cycle of coordinated lights, taken from the plan's day cycle.
+// Cycle positions count from the Unix epoch, so every controller whose clock
+// is synchronized agrees on them without talking to the others; a light's
+// offset is where its main-street green starts in the cycle.
+typedef struct
+{
+    SimTime cycle;    // Length of the day cycle
+    SimTime green;    // Main-street green at the start of the cycle
+    int sync_state;   // Longest phase without the main street: stretched or cut to keep the offset
+    SimTime sync_end; // Where that phase ends, after the start of the green
+} Coordination;
+
+// Intersections 0..num_intersections-1 along a main street, in order
+typedef struct
+{
+    int num_intersections;
+    double position[MAX_CORRIDOR_LENGTH]; // Metres from the first intersection
+    SimTime offset[MAX_CORRIDOR_LENGTH];  // Start of the main-street green in the cycle
+    bool has_offsets;                     // Given in the file; otherwise optimize_offsets() sets them
+    double speed;                         // Design speed, metres per second
+    bool coordinated;                     // false: the lights run free (for comparison)
+    SimTime start_phase[MAX_CORRIDOR_LENGTH]; // Free-running lights: where in the day cycle each one starts
+    Coordination timing;
+} Corridor;
+
+int load_corridor(const char *filename, Corridor *corridor);    // Read a corridor file, see corridors/main_street.corridor
+int corridor_timing(Corridor *corridor, const PhasePlan *plan); // Derive the common cycle from the plan
+SimTime corridor_travel_time(const Corridor *corridor, int from, int to); // At the design speed, to the ms
+SimTime corridor_bandwidth(const Corridor *corridor, int direction);      // Width of the green band of OUTBOUND or INBOUND
+void optimize_offsets(Corridor *corridor);                      // Offsets with the widest bands in both directions
+void randomize_start_phases(Corridor *corridor, uint64_t seed); // Independent start phases for free-running lights
+void print_corridor(const Corridor *corridor);                  // Cycle, offsets and bands
+
+#endif
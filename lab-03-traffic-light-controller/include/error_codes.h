@@ -5,7 +5,9 @@ typedef enum
 {
     SUCCESS = 0,
     INVALID_STATE,
-    UNKNOWN_ERROR
+    UNKNOWN_ERROR,
+    EVENT_LOOP_ERROR, // Timer or epoll set could not be set up
+    INVALID_ARGUMENT  // Bad command-line option or script
 } ErrorCode;
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "clock.h"
+
+#define EVENT_QUEUE_SIZE 1024 // Events per queue, a power of two
+#define CACHE_LINE_SIZE 64
+
+// Kinds of input the controller reacts to
+typedef enum
+{
+    INPUT_PEDESTRIAN, // Pedestrian button pressed
+    INPUT_DETECTOR,   // Vehicle loop detector triggered
+    INPUT_OVERRIDE,   // Operator forces a mode ('value' is a DayMode, -1 to follow the schedule)
+} InputType;
+
+typedef struct
+{
+    SimTime time;         // When the input happened (simulated time)
+    int64_t enqueued_ns;  // CLOCK_MONOTONIC at enqueue, for the service latency
+    int32_t intersection;
+    int32_t value;
+    InputType type;
+} InputEvent;
+
+typedef struct
+{
+    atomic_size_t sequence; // Slot is free for the producer at 'position', filled at 'position + 1'
+    InputEvent event;
+} EventSlot;
+
+// Bounded lock-free multi-producer, single-consumer queue. Producers claim a
+// position with a compare-and-swap on 'tail' and publish the event by
+// advancing the slot's sequence number; the single consumer needs no atomic
+// read-modify-write at all. A full queue rejects the event instead of blocking
+// (the producer is an input thread that must not stall).
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail; // Next position to claim (producers)
+    _Alignas(CACHE_LINE_SIZE) size_t head;        // Next position to read (consumer)
+    atomic_size_t dropped;                        // Events rejected because the queue was full
+    EventSlot slots[EVENT_QUEUE_SIZE];
+} EventQueue;
+
+void event_queue_init(EventQueue *queue);
+bool event_queue_push(EventQueue *queue, const InputEvent *event); // Any thread; false if full
+bool event_queue_pop(EventQueue *queue, InputEvent *event);        // Consumer only; false if empty
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <pthread.h>
+#include "controller.h"
+
+// A thread that turns the lines of one input source into queued events:
+//   b [ID]                        pedestrian button (default intersection without ID)
+//   d ID [APPROACH]               vehicle detector (approach 0 without APPROACH)
+//   o ID day|blink|night|auto     operator override, 'auto' follows the schedule again
+typedef struct
+{
+    Grid *grid;
+    int fd;
+    pthread_t thread;
+} InputReader;
+
+int parse_input_line(const char *line, int default_light, InputType *type, int *intersection, int *value); // SUCCESS or INVALID_ARGUMENT
+int load_detector_replay(const char *filename, SimTime start, InputEvent **events, int *count); // Timestamped detector CSV
+int start_input_reader(InputReader *reader, Grid *grid, int fd); // Read 'fd' on a new thread
+void stop_input_reader(InputReader *reader);                     // Cancel and join the thread
+
+#endif
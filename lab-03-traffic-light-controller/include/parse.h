@@ -0,0 +1,12 @@
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stdbool.h>
+
+// Numbers in plan and corridor files and on the command line. The whole field
+// must be the number: an empty field, trailing characters ("10abc") or a
+// value outside [min, max] is rejected instead of read as 0 or 10.
+bool parse_int(const char *text, int min, int max, int *value);             // Decimal integer
+bool parse_double(const char *text, double min, double max, double *value); // Finite decimal number
+
+#endif
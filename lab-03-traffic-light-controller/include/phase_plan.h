@@ -0,0 +1,83 @@
+#ifndef PHASE_PLAN_H
+#define PHASE_PLAN_H
+
+#include <stdint.h>
+
+#define MAX_PLAN_STATES 16
+#define MAX_PLAN_MESSAGES 16
+#define PLAN_NAME_LENGTH 24
+#define PLAN_TEXT_LENGTH 96
+#define MAX_APPROACHES 4 // Detected approaches per intersection
+
+#define DURATION_UNTIL_MODE_CHANGE (-1) // Phase lasts until the schedule changes the mode (night)
+
+// Transition flags
+#define TRANSITION_QUIET 0x01 // Do not print the new state (e.g. the night staying OFF)
+#define TRANSITION_SERVE 0x02 // The transition serves the pending pedestrian request
+
+// What ended a phase: its timer, or the schedule changing the mode. The mode
+// takes priority, then a pending pedestrian request, then the plain timer.
+typedef enum
+{
+    EVENT_TIMER,      // Phase over, nothing else pending
+    EVENT_PEDESTRIAN, // Phase over with a pedestrian request pending
+    EVENT_BLINK,      // Phase over (or cut short) in the blinking yellow mode
+    EVENT_NIGHT,      // Phase over (or cut short) in the night mode
+    NUM_PHASE_EVENTS
+} PhaseEvent;
+
+// One cell of the transition table
+typedef struct
+{
+    uint8_t next;     // State entered
+    uint8_t flags;    // TRANSITION_QUIET, TRANSITION_SERVE
+    uint8_t message;  // Announcement printed first: index into 'messages', 0 for none
+    int32_t duration; // Length of the new phase in seconds, or DURATION_UNTIL_MODE_CHANGE
+} Transition;
+
+// Vehicle-actuated timing of a state. The transition into the state gives
+// the minimum green; each detection on a served approach extends the phase
+// by 'gap' seconds, up to 'max_green' seconds in all.
+typedef struct
+{
+    int32_t max_green; // Longest the phase may last, 0 for a fixed length
+    int32_t gap;       // Extension per detection (passage time)
+} Actuation;
+
+// How pedestrian requests are served. A press while pedestrians may start
+// crossing joins them instead of calling for another walk. A request that has
+// waited 'max_wait' seconds cuts the current phase short, but only a state
+// with a minimum green, and only once that has run; clearance phases such as
+// YELLOW have none and always run out.
+typedef struct
+{
+    int32_t max_wait;                   // Seconds a request waits before it preempts
+    int32_t min_green[MAX_PLAN_STATES]; // Seconds before a request may cut the state short, 0 never
+    uint16_t walk;                      // Bit s: pedestrians may start crossing in state s
+} PedestrianPolicy;
+
+// A phase plan: the states with their displayed output, and for every state
+// and event the transition to take. The controller only looks cells up, so a
+// different plan (e.g. with a pedestrian walk phase) needs no code changes.
+// Approach 0 is the one facing the light and approach 2 the opposite one, on
+// the main street; the crossing street (approach 1) has green while the
+// light shows RED.
+typedef struct
+{
+    int num_states;
+    int initial;          // State at start-up
+    int initial_duration; // Its length in seconds
+    int num_messages;     // Entry 0 is the empty message
+    char state_names[MAX_PLAN_STATES][PLAN_NAME_LENGTH]; // Output of each state, e.g. "RED+YELLOW"
+    char messages[MAX_PLAN_MESSAGES][PLAN_TEXT_LENGTH];
+    Transition table[MAX_PLAN_STATES][NUM_PHASE_EVENTS];
+    uint8_t serves[MAX_PLAN_STATES];        // Bit a: vehicles of approach a may go
+    Actuation actuation[MAX_PLAN_STATES];
+    PedestrianPolicy pedestrian;
+} PhasePlan;
+
+extern const PhasePlan default_phase_plan; // The built-in plan (states as in TrafficLightState)
+
+int load_phase_plan(const char *filename, PhasePlan *plan); // Read a plan file, see plans/default.plan
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "clock.h"
+
+// Built-in schedule (local time)
+#define NIGHT_START 22           // Night starts at 22:00
+#define NIGHT_END 6              // Night ends at 06:00
+#define TRANSITION_DURATION 3600 // Blinking yellow before night and before morning (1 hour in seconds)
+
+#define MAX_SCHEDULE_PROFILES 8
+#define MAX_PROFILE_ENTRIES 16
+#define MAX_HOLIDAYS 64
+#define PROFILE_NAME_LENGTH 24
+#define NO_MODE_CHANGE INT64_MAX // The schedule never changes the mode
+
+// Operating mode of the lights for a stretch of the day
+typedef enum
+{
+    MODE_DAY,   // Normal day cycle
+    MODE_BLINK, // Blinking yellow
+    MODE_NIGHT, // Light off
+} DayMode;
+
+// A mode that starts at a local time of day
+typedef struct
+{
+    int minute; // Minutes after midnight
+    DayMode mode;
+} ScheduleEntry;
+
+// The modes of one kind of day, sorted by time; the first entry is at 00:00
+typedef struct
+{
+    char name[PROFILE_NAME_LENGTH];
+    int num_entries;
+    ScheduleEntry entries[MAX_PROFILE_ENTRIES];
+} DayProfile;
+
+typedef struct
+{
+    int date;    // YYYYMMDD
+    int profile; // Index into 'profiles'
+} Holiday;
+
+// Which profile runs on which day: one per weekday, overridden by holidays
+typedef struct
+{
+    int num_profiles;
+    DayProfile profiles[MAX_SCHEDULE_PROFILES];
+    int weekday_profile[7]; // Sunday = 0, as in struct tm
+    int num_holidays;
+    Holiday holidays[MAX_HOLIDAYS];
+} Schedule;
+
+extern const Schedule default_schedule; // Every day: night 22-5, blink 5-6 and 21-22
+
+DayMode schedule_mode(const Schedule *schedule, SimTime time, SimTime *next_change); // Mode at 'time' and when it next changes
+int load_schedule(const char *filename, Schedule *schedule);                         // Read a schedule file, see schedules/weekly.schedule
+const char *day_mode_name(DayMode mode);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "clock.h"
+#include "phase_plan.h"
+#include "schedule.h"
+#include "traffic_light.h"
+
+#define SNAPSHOT_MAGIC "TLSTATE1"
+#define SNAPSHOT_VERSION 2
+
+// The state of one light, as kept in the state file. A record is rewritten
+// in place whenever its light changes; the checksum covers everything before
+// it, so a record cut short by a crash is simply not restored.
+typedef struct
+{
+    int64_t phase_start;
+    int64_t phase_deadline;    // NO_DEADLINE while the phase lasts until the mode changes
+    int64_t request_time;      // When the pending pedestrian request was registered
+    int64_t offset;            // Start of the main-street green in the common cycle (coordinated lights)
+    int32_t intersection;
+    uint8_t state;             // Index into the plan's states
+    uint8_t mode;              // DayMode the light ran in
+    uint8_t pedestrian_request;
+    int8_t override_mode;      // -1: the light follows the schedule
+    uint32_t checksum;         // Of the fields above; a record never written is all zeros and fails it
+    uint32_t reserved;
+} LightSnapshot;
+
+_Static_assert(sizeof(LightSnapshot) == 48, "state records are 48 bytes on disk");
+
+// Start of a state file, followed by one record per light
+typedef struct
+{
+    char magic[8];          // SNAPSHOT_MAGIC, not terminated
+    uint32_t version;       // SNAPSHOT_VERSION
+    uint32_t record_size;   // sizeof(LightSnapshot)
+    int32_t num_lights;
+    uint32_t plan_checksum; // Of the plan's states, transitions and timing: the same plan runs
+    uint32_t reserved;
+    uint32_t checksum;      // Of the fields above
+} SnapshotHeader;
+
+// A state file mapped into memory
+typedef struct
+{
+    int fd;
+    SnapshotHeader *header;
+    LightSnapshot *records; // One per light, right after the header
+    size_t size;            // Of the mapping
+    bool restorable;        // The file was written by a run with the same plan and lights
+} Snapshot;
+
+int snapshot_open(Snapshot *snapshot, const char *filename, const PhasePlan *plan, int num_lights); // Map (or create) the state file
+int snapshot_close(Snapshot *snapshot);                                                     // Write back and unmap
+bool snapshot_restore(const Snapshot *snapshot, TrafficLight *light, SimTime now, DayMode scheduled); // Load a light's saved state
+uint32_t snapshot_checksum(const void *data, size_t size);                                  // 32-bit FNV-1a
+
+/*
+ * Function: snapshot_save
+ * -----------------------------
+ * Writes a light's state into its record. A few stores into the mapping: the
+ * kernel writes the page back to the file, so a crash or a restart of the
+ * process loses nothing. Only the thread that owns the light may call it.
+ */
+static inline void snapshot_save(LightSnapshot *record, const TrafficLight *light, DayMode mode)
+{
+    record->phase_start = light->phase_start;
+    record->phase_deadline = light->phase_deadline;
+    record->request_time = light->request_time;
+    record->offset = light->offset;
+    record->intersection = light->id;
+    record->state = (uint8_t)light->state;
+    record->mode = (uint8_t)mode;
+    record->pedestrian_request = light->pedestrian_request;
+    record->override_mode = (int8_t)light->override_mode;
+    record->checksum = snapshot_checksum(record, offsetof(LightSnapshot, checksum));
+}
+
+#endif
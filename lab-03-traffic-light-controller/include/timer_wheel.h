@@ -0,0 +1,45 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TIMER_TICK_NS 1000000 // Wheel resolution: 1 ms
+#define WHEEL_LEVELS 4        // Level n slots are 256^n ticks wide: 1 ms, 256 ms, 65 s, 4.6 h
+#define WHEEL_BITS 8
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+// Intrusive timer: embedded in the object it belongs to, so adding and
+// removing timers never allocates
+typedef struct TimerEntry
+{
+    struct TimerEntry *next;
+    struct TimerEntry *prev;
+    uint64_t expires;   // Tick at which the timer fires
+    uint8_t level;      // Slot the entry is linked into
+    uint8_t slot;
+} TimerEntry;
+
+// Hierarchical timing wheel (as in the classic Linux kernel timers).
+// A timer goes into the coarsest level whose slot width still separates it
+// from 'now'; when level 0 wraps around, the next slot of level 1 is spread
+// out over level 0, and so on. Adding and removing a timer is O(1), and a
+// bitmap of the non-empty slots lets advance() skip idle stretches.
+typedef struct
+{
+    uint64_t now; // Next tick to process
+    size_t count; // Timers currently in the wheel
+    TimerEntry slots[WHEEL_LEVELS][WHEEL_SLOTS]; // List heads (sentinels)
+    uint64_t occupied[WHEEL_LEVELS][WHEEL_SLOTS / 64]; // Bit set if the slot is not empty
+} TimerWheel;
+
+typedef void (*TimerCallback)(TimerEntry *entry, void *context);
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t start_tick);
+void timer_wheel_add(TimerWheel *wheel, TimerEntry *entry, uint64_t expires); // Fires at tick 'expires' (or the next tick if that has passed)
+void timer_wheel_remove(TimerWheel *wheel, TimerEntry *entry);               // Cancel a pending timer
+void timer_wheel_advance(TimerWheel *wheel, uint64_t tick, TimerCallback callback, void *context); // Run every timer up to and including 'tick'
+uint64_t timer_wheel_next_tick(const TimerWheel *wheel); // Earliest tick at which advance() has work, UINT64_MAX if empty
+
+#endif
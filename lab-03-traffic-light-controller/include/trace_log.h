@@ -0,0 +1,122 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "clock.h"
+#include "phase_plan.h"
+#include "event_queue.h" // CACHE_LINE_SIZE
+
+#define TRACE_MAGIC "TLTRACE1"
+#define TRACE_VERSION 1
+#define TRACE_RING_SIZE 65536     // Records per ring, a power of two (1 MiB)
+#define TRACE_FLUSH_INTERVAL_MS 10 // Flusher sleep when all rings are empty
+#define TRACE_NO_MODE 0xFF
+
+// Why a record was written. The first four are the phase events of the plan.
+typedef enum
+{
+    TRACE_CAUSE_TIMER,      // Phase over
+    TRACE_CAUSE_PEDESTRIAN, // Phase over with a pedestrian request pending
+    TRACE_CAUSE_BLINK,      // Phase over in the blinking yellow mode
+    TRACE_CAUSE_NIGHT,      // Phase over in the night mode
+    TRACE_CAUSE_START,      // Controller started (old and new state are the same)
+    TRACE_CAUSE_SCHEDULE,   // The schedule changed the mode, phase cut short
+    TRACE_CAUSE_OVERRIDE,   // The operator set or released the mode
+    TRACE_CAUSE_PRESS,      // Pedestrian request registered (no state change)
+    TRACE_CAUSE_GAP_OUT,    // Actuated phase over: no vehicle within the gap
+    TRACE_CAUSE_MAX_OUT,    // Actuated phase over: maximum green reached
+    TRACE_CAUSE_RESUME,     // Controller restarted from its state file (old and new state are the same)
+    NUM_TRACE_CAUSES
+} TraceCause;
+
+// One event, as written to the file
+typedef struct
+{
+    int64_t time;         // Simulated time, nanoseconds since the epoch
+    int32_t intersection;
+    uint8_t old_state;    // Index into the plan's states (see the file header)
+    uint8_t new_state;
+    uint8_t cause;        // TraceCause
+    uint8_t mode;         // DayMode the light runs in, TRACE_NO_MODE if not known
+} TraceRecord;
+
+_Static_assert(sizeof(TraceRecord) == 16, "trace records are 16 bytes on disk");
+
+// Start of a trace file, followed by the records. The state names make the
+// file readable without the plan it was recorded with.
+typedef struct
+{
+    char magic[8];          // TRACE_MAGIC, not terminated
+    uint32_t version;       // TRACE_VERSION
+    uint32_t record_size;   // sizeof(TraceRecord)
+    int64_t start;          // Simulated start time
+    int32_t num_states;
+    int32_t reserved;
+    char state_names[MAX_PLAN_STATES][PLAN_NAME_LENGTH];
+} TraceFileHeader;
+
+// Single-producer, single-consumer ring between a shard thread and the
+// flusher. The producer only touches its own cache line unless its cached
+// view of the consumer says the ring is full, so a record costs a 16-byte
+// store and one release store of 'head'.
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head; // Next record to write (producer)
+    size_t cached_tail;                           // Producer's last view of 'tail'
+    bool lossless;                                // Wait for the flusher instead of dropping
+    atomic_size_t dropped;                        // Records lost because the ring was full
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail; // Next record to flush (consumer)
+    TraceRecord records[TRACE_RING_SIZE];
+} TraceRing;
+
+// A trace file with one ring per shard thread and the thread that empties them
+typedef struct
+{
+    FILE *file;
+    TraceRing *rings;
+    int num_rings;
+    pthread_t flusher;
+    atomic_bool stop;
+    long written; // Records in the file
+    long dropped; // Records lost because a ring was full (after trace_log_close())
+    int result;   // ErrorCode of the flusher
+} TraceLog;
+
+int trace_log_open(TraceLog *log, const char *filename, const PhasePlan *plan, SimTime start,
+                   int num_rings, bool lossless); // Create the file and start the flusher
+int trace_log_close(TraceLog *log);               // Flush everything, stop the flusher, close the file
+bool trace_ring_wait(TraceRing *ring, size_t head); // Slow path of trace_ring_push(): the ring is full
+
+int trace_read_header(FILE *file, TraceFileHeader *header); // Read and check the header of a trace file
+const char *trace_cause_name(TraceCause cause);             // e.g. "timer"
+
+/*
+ * Function: trace_ring_push
+ * -----------------------------
+ * Appends a record to a shard's ring. Only the shard's own thread may call it.
+ * Never blocks on a real-time clock: a full ring drops the record and counts it.
+ */
+static inline void trace_ring_push(TraceRing *ring, SimTime time, int intersection, int old_state, int new_state,
+                                   TraceCause cause, int mode)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - ring->cached_tail == TRACE_RING_SIZE && !trace_ring_wait(ring, head))
+    {
+        return;
+    }
+
+    TraceRecord *record = &ring->records[head & (TRACE_RING_SIZE - 1)];
+    record->time = time;
+    record->intersection = intersection;
+    record->old_state = (uint8_t)old_state;
+    record->new_state = (uint8_t)new_state;
+    record->cause = (uint8_t)cause;
+    record->mode = (uint8_t)mode;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+#endif
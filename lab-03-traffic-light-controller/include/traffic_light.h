@@ -2,22 +2,17 @@
 #define TRAFFIC_LIGHT_H
 
 #include <stdbool.h>
+#include <stdatomic.h>
+#include "clock.h"
+#include "timer_wheel.h"
+#include "phase_plan.h"
+#include "schedule.h"
+#include "trace_log.h"
+#include "corridor.h"
 
-// Traffic light durations (in seconds)
-#define RED_DURATION 10
-#define YELLOW_DURATION 2
-#define GREEN_DURATION 15
-#define RED_YELLOW_DURATION 2
+#define NO_DEADLINE INT64_MAX // The phase lasts until the mode changes
 
-// Transition durations (1 hour in seconds)
-#define TRANSITION_DURATION 3600
-#define BLINKING_YELLOW_INTERVAL 1
-
-// Night period
-#define NIGHT_START 22 // Night starts at 22:00
-#define NIGHT_END 6    // Night ends at 06:00
-
-// Enumerated states for traffic lights
+// States of the built-in phase plan
 typedef enum
 {
     RED,
@@ -28,13 +23,57 @@ typedef enum
     OFF
 } TrafficLightState;
 
-int init_traffic_light(void);         // Init the traffic light controller
-int run_traffic_light(void);          // Run the traffic light controller
-const char *get_light_color(void);    // Returns a pointer to a string representing the current light color
-int button_press_request(void);       // Handle pedestrian button press
-bool is_blinking_yellow_period(void); // Check for transition periods
-bool is_night_period(void);           // Check if it's night
-void handle_blinking_yellow(void);    // Manage blinking yellow behavior
-void handle_night_period(void);       // Manage night OFF state
+// What became of a pedestrian button press
+typedef enum
+{
+    PRESS_REGISTERED, // A new request
+    PRESS_PENDING,    // Part of the request already pending
+    PRESS_JOINED,     // Pedestrians are crossing: served at once
+} PressResult;
+
+// How much of a controller's activity is printed
+typedef enum
+{
+    TRACE_OFF,     // Silent (large grids)
+    TRACE_ON,      // Every transition, as the single-intersection controller prints it
+    TRACE_WITH_ID, // Every transition, prefixed with the intersection number
+} TraceMode;
+
+// One intersection. The controller keeps no global state, so any number of
+// these can be driven by the same event loop; the timer entry links the light
+// into the timing wheel of the shard that owns it.
+typedef struct
+{
+    TimerEntry timer;        // Phase deadline in the owner's timing wheel (first member)
+    int id;                  // Intersection number
+    int state;               // Current state: index into the plan's states
+    const PhasePlan *plan;   // Transition table the light follows
+    bool pedestrian_request; // Pedestrian light status (off by default)
+    SimTime request_time;    // When the pending request was registered
+    SimTime day_start;       // When the light last entered the day mode (set by the controller)
+    atomic_bool button_latched; // Set by the input threads on a press, cleared when served
+    int override_mode;       // DayMode forced by the operator, -1 to follow the schedule
+    uint8_t calls;           // Bit a: a vehicle waits on approach a for its green
+    SimTime last_detection[MAX_APPROACHES]; // Latest detector event per approach
+    TraceMode trace;
+    TraceRing *log;          // Binary trace of the owning shard, NULL for none
+    const Clock *clock;      // Only used to format the trace
+    SimTime phase_start;     // When the current phase began (simulated time)
+    SimTime phase_deadline;  // When it ends
+    const Coordination *coordination; // Common cycle of the light's corridor, NULL to run free
+    SimTime offset;          // Start of the main-street green in that cycle
+    SimTime start_phase;     // Running free: how far into the day cycle the light starts
+} TrafficLight;
+
+int init_traffic_light(TrafficLight *light, int id, const PhasePlan *plan, const Clock *clock, TraceMode trace); // Init one intersection in the plan's initial state
+SimTime start_traffic_light(TrafficLight *light, SimTime now, DayMode mode); // Enter the first phase, returns its deadline
+SimTime resume_traffic_light(TrafficLight *light, SimTime now, DayMode mode); // Carry on in a restored phase, returns its deadline
+SimTime step_traffic_light(TrafficLight *light, SimTime now, DayMode mode);  // Phase deadline reached: next phase, returns its deadline (-1 if stuck)
+SimTime change_traffic_light_mode(TrafficLight *light, SimTime now, DayMode mode); // The schedule changed the mode: cut the phase short
+PressResult press_button(TrafficLight *light, SimTime now);   // Pedestrian button press; a request may move the phase deadline
+void detect_vehicle(TrafficLight *light, SimTime now, int approach); // Register a vehicle at a loop detector
+SimTime override_traffic_light(TrafficLight *light, SimTime now, int mode, DayMode scheduled); // Operator forces 'mode' (-1: back to the schedule)
+DayMode traffic_light_mode(const TrafficLight *light, DayMode scheduled); // The mode the light runs in
+const char *get_light_color(const TrafficLight *light);       // Returns a pointer to a string representing the current light color
 
 #endif
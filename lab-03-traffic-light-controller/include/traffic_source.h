@@ -0,0 +1,36 @@
+#ifndef TRAFFIC_SOURCE_H
+#define TRAFFIC_SOURCE_H
+
+#include <stdint.h>
+#include "clock.h"
+#include "timer_wheel.h"
+#include "phase_plan.h"
+
+#define PEDESTRIAN_SOURCE (-1) // Approach of a source of pedestrians
+
+// Demand at every intersection of a simulation, as Poisson arrival rates
+typedef struct
+{
+    double vehicles_per_hour[MAX_APPROACHES];
+    double pedestrians_per_hour;
+    uint64_t seed; // The same seed gives the same arrivals, whatever the number of threads
+} TrafficDemand;
+
+// Random arrivals of vehicles on one approach, or of pedestrians at the
+// button, of one intersection. Each source has its own generator, so the
+// arrivals do not depend on the order in which shards run.
+typedef struct
+{
+    TimerEntry timer; // Next arrival in the shard's source wheel (first member)
+    int light;        // Index of the light in its shard
+    int approach;     // Approach of the vehicles, or PEDESTRIAN_SOURCE
+    double mean_gap;  // Mean time between arrivals, ns
+    uint64_t random;  // xorshift64* state
+    SimTime next;     // Time of the next arrival, on a wheel tick
+} TrafficSource;
+
+void traffic_source_init(TrafficSource *source, int light, int intersection, int approach, double per_hour,
+                         uint64_t seed, SimTime start); // Draw the first arrival after 'start'
+SimTime traffic_source_next(TrafficSource *source);      // Draw the arrival after the current one
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef VEHICLE_QUEUE_H
+#define VEHICLE_QUEUE_H
+
+#include <stdbool.h>
+#include "clock.h"
+
+#define SATURATION_HEADWAY (2 * NS_PER_SECOND) // A queue moves off one vehicle per 2 s (1800 per hour)
+#define START_UP_LOST_TIME (2 * NS_PER_SECOND) // Before the first vehicle moves when the green starts
+
+// The main street between two lights of a corridor. Vehicles leave the
+// upstream stop line at least a saturation headway apart and all take the
+// same time, so they arrive in the order they left and no more than
+// 'capacity' are ever on the way.
+typedef struct
+{
+    struct VehicleQueue *from; // Upstream queue
+    int light;               // Downstream light, index in its shard
+    int approach;            // Downstream approach
+    SimTime travel;
+    SimTime *arrivals;       // Ring of arrival times downstream
+    int capacity;
+    int head;
+    int count;
+} VehicleLink;
+
+// The vehicles waiting at the stop line of one approach. Every detector event
+// is a vehicle arriving; while the approach has green the queue moves off at
+// the saturation flow. Nothing is stored per vehicle: the total wait is the
+// queue length integrated over time.
+typedef struct VehicleQueue
+{
+    int length;             // Vehicles waiting
+    int max_length;
+    bool green;
+    long arrived;
+    long served;            // Vehicles that crossed the stop line
+    long stops;             // Vehicles that arrived on red or behind a queue
+    SimTime last_update;
+    SimTime next_departure; // Earliest the head of the queue can go (while green)
+    double total_wait;      // Vehicle-seconds spent in the queue
+    SimTime green_time;     // How long the approach has had green
+    VehicleLink *downstream; // Where the vehicles go next, NULL if they leave the model
+} VehicleQueue;
+
+void vehicle_queue_init(VehicleQueue *queue, SimTime now);
+void vehicle_queue_advance(VehicleQueue *queue, SimTime now);                // Let the queue move off until 'now'
+void vehicle_queue_arrive(VehicleQueue *queue, SimTime now);                 // One more vehicle
+void vehicle_queue_set_green(VehicleQueue *queue, SimTime now, bool green); // The signal for the approach changed
+SimTime vehicle_queue_next_departure(const VehicleQueue *queue);             // INT64_MAX if nobody can go
+
+int vehicle_link_init(VehicleLink *link, VehicleQueue *from, int light, int approach, SimTime travel);
+void vehicle_link_free(VehicleLink *link);
+SimTime vehicle_link_pop(VehicleLink *link); // Take the first vehicle on the way, returns its arrival time
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "clock.h"
+#include "error_codes.h"
+
+static SimTime read_clock(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (SimTime)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+}
+
+int clock_init(Clock *clock, ClockMode mode, double speed, SimTime start)
+{
+    if (clock == NULL || (mode == CLOCK_MODE_SCALED && speed <= 0.0))
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    clock->mode = mode;
+    clock->speed = (mode == CLOCK_MODE_SCALED) ? speed : 1.0;
+    clock->start = (start < 0 || mode == CLOCK_MODE_REAL) ? read_clock(CLOCK_REALTIME) : start;
+    clock->real_start = read_clock(CLOCK_MONOTONIC);
+    clock->now = clock->start;
+
+    return SUCCESS;
+}
+
+// Real and scaled time are measured on CLOCK_MONOTONIC from the start, so
+// setting the system clock while running does not disturb the phase timing
+SimTime clock_now(const Clock *clock)
+{
+    if (clock->mode == CLOCK_MODE_VIRTUAL)
+    {
+        return clock->now;
+    }
+
+    SimTime elapsed = read_clock(CLOCK_MONOTONIC) - clock->real_start;
+    return clock->start + (SimTime)(elapsed * clock->speed);
+}
+
+void clock_advance(Clock *clock, SimTime time)
+{
+    if (clock->mode == CLOCK_MODE_VIRTUAL && time > clock->now)
+    {
+        clock->now = time;
+    }
+}
+
+struct timespec clock_monotonic_deadline(const Clock *clock, SimTime time)
+{
+    SimTime real = clock->real_start + (SimTime)((time - clock->start) / clock->speed);
+    struct timespec deadline = {.tv_sec = real / NS_PER_SECOND, .tv_nsec = real % NS_PER_SECOND};
+    return deadline;
+}
+
+void clock_local_time(SimTime time, struct tm *local_time)
+{
+    time_t seconds = (time_t)(time / NS_PER_SECOND);
+    localtime_r(&seconds, local_time); // Unlike localtime(), no shared static buffer
+}
+
+void clock_format(SimTime time, char *buffer, size_t size)
+{
+    struct tm local_time;
+    clock_local_time(time, &local_time);
+    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &local_time);
+}
+
+int clock_parse(const char *text, SimTime *time)
+{
+    struct tm local_time;
+    memset(&local_time, 0, sizeof(local_time));
+
+    if (sscanf(text, "%d-%d-%d %d:%d:%d", &local_time.tm_year, &local_time.tm_mon, &local_time.tm_mday,
+               &local_time.tm_hour, &local_time.tm_min, &local_time.tm_sec) != 6)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    local_time.tm_year -= 1900;
+    local_time.tm_mon -= 1;
+    local_time.tm_isdst = -1; // Let mktime work out daylight saving time
+
+    time_t seconds = mktime(&local_time);
+    if (seconds == (time_t)-1)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    *time = (SimTime)seconds * NS_PER_SECOND;
+    return SUCCESS;
+}
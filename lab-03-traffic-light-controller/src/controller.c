@@ -0,0 +1,1340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/epoll.h>   // Waiting for several event sources at once
+#include <sys/timerfd.h> // Phase deadlines as a file descriptor
+#include <sys/eventfd.h> // Wake-up of a shard by the input threads
+#include "controller.h"
+#include "input.h"
+#include "error_codes.h"
+
+#define MAX_EVENTS 4 // Events handled per epoll_wait call
+
+// Wheel tick of a simulated time, rounded up so a timer never fires early
+static uint64_t time_to_tick(SimTime time)
+{
+    return (uint64_t)((time + TIMER_TICK_NS - 1) / TIMER_TICK_NS);
+}
+
+static SimTime tick_to_time(uint64_t tick)
+{
+    return (tick == UINT64_MAX) ? INT64_MAX : (SimTime)tick * TIMER_TICK_NS;
+}
+
+// Keep the light's record in the state file up to date
+static void save_light(ControllerShard *shard, const TrafficLight *light)
+{
+    if (shard->snapshots != NULL)
+    {
+        snapshot_save(&shard->snapshots[light->id], light, traffic_light_mode(light, shard->mode));
+    }
+}
+
+// Put a light's new phase deadline into the wheel
+static void schedule_light(ControllerShard *shard, TrafficLight *light, SimTime deadline)
+{
+    save_light(shard, light);
+    if (deadline < 0)
+    {
+        shard->result = INVALID_STATE;
+    }
+    else if (deadline != NO_DEADLINE)
+    {
+        timer_wheel_add(&shard->wheel, &light->timer, time_to_tick(deadline));
+    }
+}
+
+// Spread phases that start at the same instant over GRID_STAGGER_MS, so the
+// intersections do not all change phase in the same tick again and again.
+// Coordinated lights are spread by their offsets instead.
+static SimTime stagger(TrafficLight *light, SimTime deadline)
+{
+    if (light->coordination == NULL && deadline >= 0 && deadline != NO_DEADLINE)
+    {
+        light->phase_deadline = deadline + (SimTime)(light->id % GRID_STAGGER_MS) * (NS_PER_SECOND / 1000);
+        return light->phase_deadline;
+    }
+
+    return deadline;
+}
+
+// The traffic model's queues of a light
+static VehicleQueue *light_queues(ControllerShard *shard, const TrafficLight *light)
+{
+    return &shard->queues[(light - shard->lights) * MAX_APPROACHES];
+}
+
+// Tell the traffic model which approaches may go after a phase change
+static void update_queues(ControllerShard *shard, const TrafficLight *light, SimTime now)
+{
+    if (shard->queues == NULL)
+    {
+        return;
+    }
+
+    VehicleQueue *queues = light_queues(shard, light);
+    uint8_t served = light->plan->serves[light->state];
+    for (int a = 0; a < MAX_APPROACHES; a++)
+    {
+        vehicle_queue_set_green(&queues[a], now, (served & (1 << a)) != 0);
+    }
+}
+
+// A standing queue occupies the stop-line detector of its approach: the
+// light sees those vehicles before it decides whether its phase goes on
+static void detect_queues(ControllerShard *shard, TrafficLight *light, SimTime now)
+{
+    if (shard->queues == NULL)
+    {
+        return;
+    }
+
+    VehicleQueue *queues = light_queues(shard, light);
+    for (int a = 0; a < MAX_APPROACHES; a++)
+    {
+        vehicle_queue_advance(&queues[a], now);
+        if (queues[a].length > 0)
+        {
+            detect_vehicle(light, now, a);
+        }
+    }
+}
+
+// A vehicle arrives at a detector
+static void vehicle_detected(ControllerShard *shard, TrafficLight *light, int approach, SimTime time)
+{
+    if (shard->queues != NULL)
+    {
+        vehicle_queue_arrive(&light_queues(shard, light)[approach], time);
+    }
+    detect_vehicle(light, time, approach);
+}
+
+// When a corridor link has work next: a vehicle of its upstream queue may
+// cross the stop line, or one on the way reaches the next light
+static SimTime link_due(const VehicleLink *link)
+{
+    SimTime due = vehicle_queue_next_departure(link->from);
+    if (link->count > 0 && link->arrivals[link->head] < due)
+    {
+        due = link->arrivals[link->head];
+    }
+
+    return due;
+}
+
+// The corridor link with the earliest work. A corridor has fewer than
+// 2 * MAX_CORRIDOR_LENGTH links, and their queues change with almost every
+// event, so they are looked through rather than kept in a wheel.
+static VehicleLink *next_link(ControllerShard *shard, SimTime *due)
+{
+    VehicleLink *next = NULL;
+    *due = INT64_MAX;
+    for (int i = 0; i < shard->num_links; i++)
+    {
+        SimTime time = link_due(&shard->links[i]);
+        if (time < *due)
+        {
+            *due = time;
+            next = &shard->links[i];
+        }
+    }
+
+    return next;
+}
+
+// Move the vehicles of a link on: those that crossed the upstream stop line
+// set off, and those that have covered the distance join the next queue
+static void move_link(ControllerShard *shard, VehicleLink *link, SimTime now)
+{
+    vehicle_queue_advance(link->from, now);
+    while (link->count > 0 && link->arrivals[link->head] <= now)
+    {
+        SimTime time = vehicle_link_pop(link);
+        vehicle_detected(shard, &shard->lights[link->light], link->approach, time);
+    }
+}
+
+// Account for the pedestrian request a phase change has served, if any
+static void count_served(ControllerShard *shard, const TrafficLight *light, bool pending, SimTime now)
+{
+    if (!pending || light->pedestrian_request)
+    {
+        return;
+    }
+
+    // A request from the night only tells how long the night is
+    SimTime wait = now - light->request_time;
+    if (light->request_time < light->day_start)
+    {
+        shard->stats.requests_deferred++;
+        shard->stats.total_deferred_wait += wait;
+        return;
+    }
+
+    long second = (long)(wait / NS_PER_SECOND);
+    shard->stats.requests_served++;
+    shard->stats.total_request_wait += wait;
+    shard->stats.request_wait_histogram[(second < PEDESTRIAN_WAIT_BUCKETS) ? second : PEDESTRIAN_WAIT_BUCKETS - 1]++;
+    if (wait > shard->stats.max_request_wait)
+    {
+        shard->stats.max_request_wait = wait;
+    }
+}
+
+// A pedestrian presses the button. A new request may have cut the phase
+// short, and then the light goes back into the wheel at its new deadline.
+static void pedestrian_press(ControllerShard *shard, TrafficLight *light, SimTime time)
+{
+    SimTime deadline = light->phase_deadline;
+    shard->stats.presses++;
+    PressResult press = press_button(light, time);
+    if (press == PRESS_JOINED)
+    {
+        shard->stats.joined++;
+    }
+
+    if (light->phase_deadline != deadline)
+    {
+        timer_wheel_remove(&shard->wheel, &light->timer);
+        schedule_light(shard, light, light->phase_deadline);
+    }
+    else if (press == PRESS_REGISTERED)
+    {
+        save_light(shard, light);
+    }
+}
+
+// After a step, an override or a mode change: a transition is counted only
+// if the light left its state (actuated extensions and rests keep it)
+static void count_transition(ControllerShard *shard, const TrafficLight *light, int old_state)
+{
+    if (light->state != old_state)
+    {
+        shard->stats.transitions++;
+    }
+}
+
+// Timer wheel callback: a light's phase has ended
+static void phase_expired(TimerEntry *entry, void *context)
+{
+    ControllerShard *shard = context;
+    TrafficLight *light = (TrafficLight *)entry; // The timer is the first member
+
+    // A virtual clock handles each deadline exactly on time
+    SimTime now = light->phase_deadline;
+    if (shard->clock.mode != CLOCK_MODE_VIRTUAL)
+    {
+        now = clock_now(&shard->clock);
+    }
+
+    SimTime lateness = now - light->phase_deadline;
+    shard->stats.timers++;
+    shard->stats.total_lateness += lateness;
+    if (lateness > shard->stats.max_lateness)
+    {
+        shard->stats.max_lateness = lateness;
+    }
+
+    int old_state = light->state;
+    bool pending = light->pedestrian_request;
+    detect_queues(shard, light, now);
+    schedule_light(shard, light, step_traffic_light(light, now, traffic_light_mode(light, shard->mode)));
+    count_transition(shard, light, old_state);
+    update_queues(shard, light, now);
+    count_served(shard, light, pending, now);
+}
+
+// Source wheel callback: the next vehicles or pedestrians of a simulated
+// source arrive. Arrivals in the same tick are handled together.
+static void arrival_due(TimerEntry *entry, void *context)
+{
+    ControllerShard *shard = context;
+    TrafficSource *source = (TrafficSource *)entry; // The timer is the first member
+    TrafficLight *light = &shard->lights[source->light];
+
+    SimTime now = clock_now(&shard->clock);
+    while (source->next <= now)
+    {
+        if (source->approach == PEDESTRIAN_SOURCE)
+        {
+            shard->stats.pedestrians++;
+            pedestrian_press(shard, light, source->next);
+        }
+        else
+        {
+            shard->stats.entered[source->approach]++;
+            vehicle_detected(shard, light, source->approach, source->next);
+        }
+        traffic_source_next(source);
+    }
+
+    timer_wheel_add(&shard->source_wheel, &source->timer, (uint64_t)(source->next / TIMER_TICK_NS));
+}
+
+// The schedule boundary has been reached: look up the new mode (and the next
+// boundary) once, and switch every light of the shard on this exact instant
+static void change_mode(ControllerShard *shard)
+{
+    SimTime now = shard->mode_end;
+    DayMode mode = schedule_mode(shard->schedule, now, &shard->mode_end);
+    if (mode == shard->mode)
+    {
+        return;
+    }
+
+    shard->mode = mode;
+    for (int i = 0; i < shard->num_lights; i++)
+    {
+        TrafficLight *light = &shard->lights[i];
+        if (light->override_mode >= 0)
+        {
+            continue; // The operator has the light
+        }
+        int old_state = light->state;
+        bool pending = light->pedestrian_request;
+        timer_wheel_remove(&shard->wheel, &light->timer);
+        schedule_light(shard, light, stagger(light, change_traffic_light_mode(light, now, mode)));
+        count_transition(shard, light, old_state);
+        if (mode == MODE_DAY)
+        {
+            light->day_start = now;
+        }
+        update_queues(shard, light, now);
+        count_served(shard, light, pending, now);
+    }
+}
+
+int init_shard(ControllerShard *shard, const Clock *clock, const Schedule *schedule, TrafficLight *lights,
+               int num_lights, SimTime end, TraceRing *log, const Snapshot *snapshot)
+{
+    shard->clock = *clock;
+    shard->lights = lights;
+    shard->num_lights = num_lights;
+    shard->schedule = schedule;
+    shard->button = NULL;
+    shard->log = log;
+    shard->wake_fd = -1;
+    event_queue_init(&shard->queue);
+    atomic_init(&shard->merged, 0);
+    shard->presses = NULL;
+    shard->num_presses = 0;
+    shard->replay = NULL;
+    shard->num_replay = 0;
+    shard->queues = NULL;
+    shard->links = NULL;
+    shard->num_links = 0;
+    shard->snapshots = (snapshot != NULL) ? snapshot->records : NULL;
+    shard->end = end;
+    atomic_init(&shard->stop, false);
+    shard->stats = (ShardStats){0};
+    shard->result = SUCCESS;
+
+    if (clock->mode != CLOCK_MODE_VIRTUAL)
+    {
+        shard->wake_fd = eventfd(0, EFD_NONBLOCK);
+        if (shard->wake_fd < 0)
+        {
+            perror("Error creating input wake-up");
+            return EVENT_LOOP_ERROR;
+        }
+    }
+
+    SimTime now = clock_now(&shard->clock);
+    timer_wheel_init(&shard->wheel, time_to_tick(now));
+    timer_wheel_init(&shard->source_wheel, time_to_tick(now));
+    shard->mode = schedule_mode(schedule, now, &shard->mode_end);
+
+    // Nothing is due yet, so the burst of start records may wait for the flusher
+    bool lossless = (log != NULL) && log->lossless;
+    if (log != NULL)
+    {
+        log->lossless = true;
+    }
+
+    // A light with a valid record carries on in its saved phase
+    for (int i = 0; i < num_lights; i++)
+    {
+        TrafficLight *light = &lights[i];
+        light->log = log;
+        if (snapshot != NULL && snapshot_restore(snapshot, light, now, shard->mode))
+        {
+            shard->stats.resumed++;
+            schedule_light(shard, light, resume_traffic_light(light, now, traffic_light_mode(light, shard->mode)));
+        }
+        else
+        {
+            schedule_light(shard, light, stagger(light, start_traffic_light(light, now, shard->mode)));
+        }
+    }
+
+    if (log != NULL)
+    {
+        log->lossless = lossless;
+    }
+
+    return shard->result;
+}
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * NS_PER_SECOND + now.tv_nsec;
+}
+
+// Which shard owns an intersection (the inverse of the split in run_grid())
+static ControllerShard *shard_of(Grid *grid, int intersection)
+{
+    int t = (int)((long)intersection * grid->num_shards / grid->num_lights);
+    while (t + 1 < grid->num_shards && (long)grid->num_lights * (t + 1) / grid->num_shards <= intersection)
+    {
+        t++;
+    }
+    while (t > 0 && (long)grid->num_lights * t / grid->num_shards > intersection)
+    {
+        t--;
+    }
+
+    return &grid->shards[t];
+}
+
+/*
+ * Function: submit_input
+ * -----------------------------
+ * Queues an input event for the shard that owns the intersection and wakes
+ * that shard up. Safe to call from any number of threads at once.
+ *
+ * A button press while a request is already pending at that intersection is
+ * merged right here, with one atomic exchange, so repeated presses cannot
+ * fill the queue.
+ *
+ * Returns:
+ * - SUCCESS if the event was queued or merged.
+ * - INVALID_ARGUMENT if there is no such intersection.
+ * - UNKNOWN_ERROR if the queue was full and the event was dropped.
+ */
+int submit_input(Grid *grid, InputType type, int intersection, int value)
+{
+    if (intersection < 0 || intersection >= grid->num_lights)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    TrafficLight *light = &grid->lights[intersection];
+    ControllerShard *shard = shard_of(grid, intersection);
+
+    if (type == INPUT_PEDESTRIAN && atomic_exchange_explicit(&light->button_latched, true, memory_order_relaxed))
+    {
+        atomic_fetch_add_explicit(&shard->merged, 1, memory_order_relaxed);
+        return SUCCESS;
+    }
+
+    InputEvent event = {
+        .time = clock_now(grid->clock),
+        .enqueued_ns = monotonic_ns(),
+        .intersection = intersection,
+        .value = value,
+        .type = type,
+    };
+
+    if (!event_queue_push(&shard->queue, &event))
+    {
+        if (type == INPUT_PEDESTRIAN)
+        {
+            atomic_store_explicit(&light->button_latched, false, memory_order_relaxed);
+        }
+        return UNKNOWN_ERROR;
+    }
+
+    uint64_t one = 1;
+    if (shard->wake_fd >= 0 && write(shard->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        perror("Error waking controller");
+    }
+
+    return SUCCESS;
+}
+
+// Apply one input event to its light
+static void service_input(ControllerShard *shard, const InputEvent *event, SimTime now)
+{
+    TrafficLight *light = &shard->lights[event->intersection - shard->lights[0].id];
+
+    int64_t latency = monotonic_ns() - event->enqueued_ns;
+    int bucket = 63 - __builtin_clzll((unsigned long long)latency | 1);
+    shard->stats.inputs++;
+    shard->stats.total_input_latency += latency;
+    shard->stats.input_latency_histogram[bucket]++;
+    if (latency > shard->stats.max_input_latency)
+    {
+        shard->stats.max_input_latency = latency;
+    }
+
+    switch (event->type)
+    {
+    case INPUT_PEDESTRIAN:
+        pedestrian_press(shard, light, event->time);
+        break;
+
+    case INPUT_DETECTOR:
+        vehicle_detected(shard, light, event->value, event->time);
+        break;
+
+    case INPUT_OVERRIDE:
+        if (event->value != light->override_mode)
+        {
+            int old_state = light->state;
+            DayMode old_mode = traffic_light_mode(light, shard->mode);
+            bool pending = light->pedestrian_request;
+            timer_wheel_remove(&shard->wheel, &light->timer);
+            schedule_light(shard, light, override_traffic_light(light, now, event->value, shard->mode));
+            count_transition(shard, light, old_state);
+            if (old_mode != MODE_DAY && traffic_light_mode(light, shard->mode) == MODE_DAY)
+            {
+                light->day_start = now;
+            }
+            update_queues(shard, light, now);
+            count_served(shard, light, pending, now);
+        }
+        break;
+    }
+}
+
+// Apply everything that is queued, in arrival order
+static void drain_input(ControllerShard *shard, SimTime now)
+{
+    InputEvent event;
+    while (event_queue_pop(&shard->queue, &event))
+    {
+        service_input(shard, &event, now);
+    }
+}
+
+/*
+ * Function: run_shard_virtual
+ * -----------------------------
+ * Runs a shard on a virtual clock as a discrete-event simulation.
+ *
+ * The next event is the earliest tick the timing wheel has work for, the next
+ * boundary of the schedule, the next scripted button press, the next
+ * replayed detector event, the next simulated arrival or the next vehicle
+ * moving along a corridor, whichever comes first. The clock jumps straight
+ * to it, so a whole day of phases takes milliseconds, and the same script
+ * always produces the same trace.
+ */
+static int run_shard_virtual(ControllerShard *shard)
+{
+    int next_press = 0;
+    int next_detection = 0;
+    while (shard->result == SUCCESS)
+    {
+        uint64_t tick = timer_wheel_next_tick(&shard->wheel);
+        SimTime next_timer = tick_to_time(tick);
+        SimTime next_event = (shard->mode_end < next_timer) ? shard->mode_end : next_timer;
+        uint64_t arrival_tick = timer_wheel_next_tick(&shard->source_wheel);
+        SimTime next_arrival = tick_to_time(arrival_tick);
+        SimTime next_move;
+        VehicleLink *link = next_link(shard, &next_move);
+
+        // The earliest event goes first. At the same instant a press comes
+        // before a detection, an arrival, a vehicle moving on, and a phase change.
+        SimTime next_traffic = (next_arrival < next_move) ? next_arrival : next_move;
+        if (next_traffic > next_event)
+        {
+            next_traffic = next_event;
+        }
+        SimTime next_detection_time = (next_detection < shard->num_replay) ? shard->replay[next_detection].time : INT64_MAX;
+        if (next_press < shard->num_presses && shard->presses[next_press] <= next_traffic &&
+            shard->presses[next_press] <= next_detection_time)
+        {
+            SimTime press = shard->presses[next_press++];
+            if (press >= shard->end)
+            {
+                break;
+            }
+            clock_advance(&shard->clock, press);
+            pedestrian_press(shard, shard->button, press);
+            continue;
+        }
+        if (next_detection < shard->num_replay && next_detection_time <= next_traffic)
+        {
+            const InputEvent *detection = &shard->replay[next_detection++];
+            if (detection->time >= shard->end)
+            {
+                break;
+            }
+            clock_advance(&shard->clock, detection->time);
+            vehicle_detected(shard, &shard->lights[detection->intersection - shard->lights[0].id],
+                             detection->value, detection->time);
+            continue;
+        }
+        if (next_arrival <= next_event && next_arrival <= next_move)
+        {
+            if (next_arrival >= shard->end)
+            {
+                break;
+            }
+            clock_advance(&shard->clock, next_arrival);
+            timer_wheel_advance(&shard->source_wheel, arrival_tick, arrival_due, shard);
+            continue;
+        }
+        if (link != NULL && next_move <= next_event)
+        {
+            if (next_move >= shard->end)
+            {
+                break;
+            }
+            clock_advance(&shard->clock, next_move);
+            move_link(shard, link, next_move);
+            continue;
+        }
+
+        if (next_event >= shard->end)
+        {
+            break;
+        }
+
+        // A phase that would end on the boundary is cut short by the mode change
+        if (shard->mode_end <= next_timer)
+        {
+            clock_advance(&shard->clock, shard->mode_end);
+            change_mode(shard);
+            continue;
+        }
+
+        clock_advance(&shard->clock, next_timer);
+        timer_wheel_advance(&shard->wheel, tick, phase_expired, shard);
+    }
+
+    clock_advance(&shard->clock, shard->end);
+    return shard->result;
+}
+
+// Arm the timer for the wheel's next tick (absolute time, so a late wake-up
+// does not push the following phases back)
+static int arm_timer(ControllerShard *shard, int timer_fd)
+{
+    SimTime next = tick_to_time(timer_wheel_next_tick(&shard->wheel));
+    if (shard->mode_end < next)
+    {
+        next = shard->mode_end;
+    }
+    if (shard->end >= 0 && next > shard->end)
+    {
+        next = shard->end;
+    }
+
+    struct itimerspec timer = {0};
+    timer.it_value = clock_monotonic_deadline(&shard->clock, next);
+    if (timer.it_value.tv_sec == 0 && timer.it_value.tv_nsec == 0)
+    {
+        timer.it_value.tv_nsec = 1; // Already due; a zero value would disarm the timer
+    }
+
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &timer, NULL) != 0)
+    {
+        perror("Error arming phase timer");
+        return EVENT_LOOP_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Function: run_shard_realtime
+ * -----------------------------
+ * Runs a shard as an event loop on a real or scaled clock.
+ *
+ * Instead of sleeping through each phase, the loop waits in epoll_wait() on
+ * - one timerfd, armed for the earliest tick of the timing wheel or the next
+ *   boundary of the schedule, however many intersections the shard holds, and
+ * - an eventfd that the input threads signal after queueing an event.
+ *
+ * The thread is blocked in the kernel between events, so no CPU is used while
+ * the phases run, and an input event wakes it up immediately instead of being
+ * noticed only at the next phase change. The queue is also drained on every
+ * timer wake-up, before the phases are handled.
+ */
+static int run_shard_realtime(ControllerShard *shard)
+{
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0)
+    {
+        perror("Error creating event loop");
+        return EVENT_LOOP_ERROR;
+    }
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (timer_fd < 0)
+    {
+        perror("Error creating phase timer");
+        close(epoll_fd);
+        return EVENT_LOOP_ERROR;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = timer_fd};
+    int result = SUCCESS;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event) != 0)
+    {
+        perror("Error adding phase timer to event loop");
+        result = EVENT_LOOP_ERROR;
+    }
+
+    event.data.fd = shard->wake_fd;
+    if (result == SUCCESS && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, shard->wake_fd, &event) != 0)
+    {
+        perror("Error adding input queue to event loop");
+        result = EVENT_LOOP_ERROR;
+    }
+
+    if (result == SUCCESS)
+    {
+        result = arm_timer(shard, timer_fd);
+    }
+
+    while (result == SUCCESS && shard->result == SUCCESS && !atomic_load_explicit(&shard->stop, memory_order_acquire))
+    {
+        struct epoll_event events[MAX_EVENTS];
+        int count = epoll_wait(epoll_fd, events, MAX_EVENTS, -1); // No timeout: sleep until something happens
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue; // Interrupted by a signal
+            }
+            perror("Error waiting for events");
+            result = EVENT_LOOP_ERROR;
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            // Both descriptors hold a counter; reading it re-arms them
+            uint64_t counter;
+            if (read(events[i].data.fd, &counter, sizeof(counter)) != sizeof(counter))
+            {
+                continue; // Spurious wake-up
+            }
+
+            SimTime now = clock_now(&shard->clock);
+            drain_input(shard, now);
+            if (events[i].data.fd == shard->wake_fd)
+            {
+                result = arm_timer(shard, timer_fd); // An override may have moved a deadline
+                continue;
+            }
+
+            // Wheel tick
+            if (shard->end >= 0 && now >= shard->end)
+            {
+                close(timer_fd);
+                close(epoll_fd);
+                return shard->result;
+            }
+
+            // Phases that end before the boundary, then the mode change
+            while (now >= shard->mode_end)
+            {
+                timer_wheel_advance(&shard->wheel, time_to_tick(shard->mode_end) - 1, phase_expired, shard);
+                change_mode(shard);
+            }
+
+            timer_wheel_advance(&shard->wheel, (uint64_t)(now / TIMER_TICK_NS), phase_expired, shard);
+            result = arm_timer(shard, timer_fd);
+        }
+    }
+
+    close(timer_fd);
+    close(epoll_fd);
+    return (result != SUCCESS) ? result : shard->result;
+}
+
+// Add up the traffic model at the end of the run; vehicles still waiting
+// count with the time they have waited so far
+static void close_queues(ControllerShard *shard)
+{
+    SimTime now = clock_now(&shard->clock);
+    for (int i = 0; i < shard->num_lights * MAX_APPROACHES; i++)
+    {
+        VehicleQueue *queue = &shard->queues[i];
+        vehicle_queue_advance(queue, now);
+        shard->stats.vehicles_arrived += queue->arrived;
+        shard->stats.vehicles_served += queue->served;
+        shard->stats.vehicle_wait += queue->total_wait;
+        shard->stats.active_queues += (queue->arrived > 0);
+        shard->stats.stops[i % MAX_APPROACHES] += queue->stops;
+        shard->stats.green[i % MAX_APPROACHES] += queue->green_time;
+        if (queue->max_length > shard->stats.max_queue)
+        {
+            shard->stats.max_queue = queue->max_length;
+        }
+    }
+}
+
+int run_shard(ControllerShard *shard)
+{
+    if (shard->clock.mode == CLOCK_MODE_VIRTUAL)
+    {
+        shard->result = run_shard_virtual(shard);
+    }
+    else
+    {
+        shard->result = run_shard_realtime(shard);
+    }
+
+    if (shard->queues != NULL)
+    {
+        close_queues(shard);
+    }
+
+    return shard->result;
+}
+
+// Make a running shard's loop return at its next wake-up, which this causes
+static void stop_shard(ControllerShard *shard)
+{
+    atomic_store_explicit(&shard->stop, true, memory_order_release);
+    uint64_t one = 1;
+    if (shard->wake_fd >= 0 && write(shard->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        perror("Error stopping controller");
+    }
+}
+
+static void *shard_thread(void *arg)
+{
+    run_shard(arg);
+    return NULL;
+}
+
+static double elapsed_seconds(const struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Latency at or below which 'fraction' of the input events were served
+static double latency_percentile(const ShardStats *stats, double fraction)
+{
+    long target = (long)(fraction * (double)stats->inputs + 0.5);
+    long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += stats->input_latency_histogram[i];
+        if (seen >= target)
+        {
+            // The bucket's upper bound, but never above the largest latency measured
+            double bound = (double)(1ULL << (i + 1));
+            return (bound < (double)stats->max_input_latency) ? bound : (double)stats->max_input_latency;
+        }
+    }
+
+    return (double)stats->max_input_latency;
+}
+
+// Main-street vehicles of a corridor enter the model at its two ends and then
+// go from light to light; the crossing streets have arrivals everywhere
+static bool enters_at(const Corridor *corridor, int intersection, int approach)
+{
+    if (corridor == NULL || intersection >= corridor->num_intersections)
+    {
+        return true;
+    }
+    if (approach == MAIN_APPROACH)
+    {
+        return intersection == 0;
+    }
+    if (approach == OPPOSITE_APPROACH)
+    {
+        return intersection == corridor->num_intersections - 1;
+    }
+
+    return true;
+}
+
+// Whole seconds within which 'fraction' of the pedestrian requests were served
+static int wait_percentile(const ShardStats *stats, double fraction)
+{
+    long target = (long)(fraction * (double)stats->requests_served + 0.5);
+    long seen = 0;
+    for (int i = 0; i < PEDESTRIAN_WAIT_BUCKETS; i++)
+    {
+        seen += stats->request_wait_histogram[i];
+        if (seen >= target)
+        {
+            return i + 1;
+        }
+    }
+
+    return PEDESTRIAN_WAIT_BUCKETS;
+}
+
+static const char *approach_names[MAX_APPROACHES] = {"main street", "crossing street", "opposite main street", "approach 3"};
+
+static void print_summary(const GridConfig *config, int num_threads, const ShardStats *total, long merged,
+                          long dropped, const TraceLog *log, double wall, SimTime sim_start, double startup)
+{
+    const Clock *clock = config->clock;
+    double simulated = (double)((config->end >= 0 ? config->end : clock_now(clock)) - sim_start) / NS_PER_SECOND;
+    double mean_lateness = (total->timers > 0) ? (double)total->total_lateness / (double)total->timers : 0.0;
+
+    // Lateness is measured on the simulated clock; report it in real time
+    printf("Intersections: %d on %d thread(s)\n", config->num_lights, num_threads);
+    printf("Simulated: %.0f s in %.3f s wall time\n", simulated, wall);
+    printf("Transitions: %ld (%.0f per wall second), button presses: %ld\n",
+           total->transitions, (wall > 0.0) ? (double)total->transitions / wall : 0.0, total->presses);
+    printf("Timer lateness: mean %.3f ms, max %.3f ms\n",
+           mean_lateness / clock->speed / 1e6, (double)total->max_lateness / clock->speed / 1e6);
+
+    if (total->inputs > 0 || merged > 0 || dropped > 0)
+    {
+        printf("Input events: %ld served, %ld merged presses, %ld dropped (queue full)\n", total->inputs, merged, dropped);
+        printf("Input latency: mean %.1f us, p99 <= %.1f us, max %.1f us\n",
+               (total->inputs > 0) ? (double)total->total_input_latency / (double)total->inputs / 1e3 : 0.0,
+               latency_percentile(total, 0.99) / 1e3, (double)total->max_input_latency / 1e3);
+    }
+    if (config->replay != NULL || config->demand != NULL)
+    {
+        printf("Vehicles: %ld arrived, %ld served (%.0f per hour), mean wait %.1f s, longest queue %d\n",
+               total->vehicles_arrived, total->vehicles_served,
+               (simulated > 0.0) ? (double)total->vehicles_served * 3600.0 / simulated : 0.0,
+               (total->vehicles_arrived > 0) ? total->vehicle_wait / (double)total->vehicles_arrived : 0.0,
+               total->max_queue);
+    }
+    if (config->demand != NULL)
+    {
+        long events = total->timers + total->vehicles_arrived + total->pedestrians;
+        printf("Queue length: mean %.2f vehicles per approach with traffic\n",
+               (total->active_queues > 0 && simulated > 0.0) ? total->vehicle_wait / simulated / (double)total->active_queues : 0.0);
+        printf("Pedestrians: %ld arrived, %ld joined a crossing, %ld requests served, wait mean %.1f s, p50 < %d s, p95 < %d s, p99 < %d s, max %.1f s\n",
+               total->pedestrians, total->joined, total->requests_served,
+               (total->requests_served > 0) ? (double)total->total_request_wait / (double)total->requests_served / NS_PER_SECOND : 0.0,
+               wait_percentile(total, 0.50), wait_percentile(total, 0.95), wait_percentile(total, 0.99),
+               (double)total->max_request_wait / NS_PER_SECOND);
+        if (total->requests_deferred > 0)
+        {
+            printf("Pedestrian requests while blinking or off: %ld, served when the day mode began, after %.0f s on average\n",
+                   total->requests_deferred, (double)total->total_deferred_wait / (double)total->requests_deferred / NS_PER_SECOND);
+        }
+        printf("Stops per vehicle:");
+        for (int a = 0; a < MAX_APPROACHES; a++)
+        {
+            if (total->entered[a] > 0)
+            {
+                printf(" %s %.2f", approach_names[a], (double)total->stops[a] / (double)total->entered[a]);
+            }
+        }
+        printf("%s\n", (config->corridor != NULL) ? " (along the whole corridor)" : "");
+
+        // What the pedestrian phases and the preemptions cost the vehicles
+        printf("Green time:");
+        for (int a = 0; a < MAX_APPROACHES; a++)
+        {
+            if (total->entered[a] > 0 && simulated > 0.0)
+            {
+                printf(" %s %.1f%%", approach_names[a],
+                       100.0 * (double)total->green[a] / NS_PER_SECOND / simulated / config->num_lights);
+            }
+        }
+        printf("\n");
+        printf("Events: %ld (%.0f per wall second)\n", events, (wall > 0.0) ? (double)events / wall : 0.0);
+    }
+    if (config->log_file != NULL)
+    {
+        printf("Trace log: %ld records written to %s, %ld dropped (ring full)\n",
+               log->written, config->log_file, log->dropped);
+    }
+    if (config->state_file != NULL)
+    {
+        printf("State file: %ld of %d lights resumed from %s, started in %.3f ms\n",
+               total->resumed, config->num_lights, config->state_file, startup * 1e3);
+    }
+}
+
+/*
+ * Function: run_grid
+ * -----------------------------
+ * Runs 'num_lights' independent intersections on 'num_threads' worker threads.
+ *
+ * The intersections are split into contiguous shards, one per thread. A shard
+ * is only ever touched by its own thread, so the lights and timing wheels need
+ * no locking, and each thread sleeps until the next deadline of its own wheel.
+ * Every input source gets a reader thread that queues its events for the
+ * owning shard. With a single intersection this is the plain controller: its
+ * transitions are printed and standard input (or the press script) is its
+ * button.
+ *
+ * Returns:
+ * - SUCCESS when 'end' is reached; after a multi-intersection run (or one
+ *   with input events) a summary of the transitions, the timer lateness and
+ *   the input latency is printed.
+ * - INVALID_ARGUMENT, UNKNOWN_ERROR (allocation), INVALID_STATE or
+ *   EVENT_LOOP_ERROR otherwise.
+ */
+int run_grid(const GridConfig *config)
+{
+    const Clock *clock = config->clock;
+    int num_lights = config->num_lights;
+    int num_threads = config->num_threads;
+    int trace_id = config->trace_id;
+
+    if (clock == NULL || config->plan == NULL || config->schedule == NULL || num_lights <= 0 || num_threads <= 0 ||
+        num_threads > MAX_CONTROLLER_THREADS || config->num_inputs > MAX_INPUTS ||
+        (clock->mode == CLOCK_MODE_VIRTUAL && (config->end < 0 || config->num_inputs > 0)) ||
+        (clock->mode != CLOCK_MODE_VIRTUAL && (config->replay != NULL || config->demand != NULL)))
+    {
+        return INVALID_ARGUMENT;
+    }
+    for (int i = 0; i < config->num_replay; i++)
+    {
+        if (config->replay[i].intersection >= num_lights)
+        {
+            fprintf(stderr, "Error: No intersection %d in the detector replay\n", config->replay[i].intersection);
+            return INVALID_ARGUMENT;
+        }
+    }
+    if (num_threads > num_lights)
+    {
+        num_threads = num_lights;
+    }
+    const Corridor *corridor = config->corridor;
+    if (corridor != NULL && (corridor->num_intersections > num_lights ||
+                             ((config->replay != NULL || config->demand != NULL) &&
+                              corridor->num_intersections > num_lights / num_threads)))
+    {
+        fprintf(stderr, "Error: The corridor needs its %d intersections, in the first thread for a traffic model\n",
+                corridor->num_intersections);
+        return INVALID_ARGUMENT;
+    }
+
+    TrafficLight *lights = malloc((size_t)num_lights * sizeof(TrafficLight));
+    ControllerShard *shards = malloc((size_t)num_threads * sizeof(ControllerShard));
+    bool traffic = (config->replay != NULL || config->demand != NULL); // Run the queue model
+    VehicleQueue *queues = NULL;
+    InputEvent *replay = NULL;
+    TrafficSource *sources = NULL;
+    VehicleLink *links = NULL;
+    int num_links = 0;
+    if (traffic)
+    {
+        queues = malloc((size_t)num_lights * MAX_APPROACHES * sizeof(VehicleQueue));
+    }
+    if (traffic && corridor != NULL)
+    {
+        links = malloc((size_t)(corridor->num_intersections - 1) * 2 * sizeof(VehicleLink));
+    }
+    if (config->num_replay > 0)
+    {
+        replay = malloc((size_t)config->num_replay * sizeof(InputEvent));
+    }
+    if (config->demand != NULL)
+    {
+        sources = malloc((size_t)num_lights * (MAX_APPROACHES + 1) * sizeof(TrafficSource));
+    }
+    pthread_t threads[MAX_CONTROLLER_THREADS];
+    InputReader readers[MAX_INPUTS];
+    int result = SUCCESS;
+    if (lights == NULL || shards == NULL || (traffic && queues == NULL) || (config->num_replay > 0 && replay == NULL) ||
+        (config->demand != NULL && sources == NULL) || (traffic && corridor != NULL && links == NULL))
+    {
+        result = UNKNOWN_ERROR;
+        goto cleanup;
+    }
+
+    TraceMode trace = (num_lights == 1) ? TRACE_ON : TRACE_WITH_ID;
+    for (int i = 0; i < num_lights; i++)
+    {
+        init_traffic_light(&lights[i], i, config->plan, clock, (i == trace_id) ? trace : TRACE_OFF);
+    }
+
+    // Coordinated lights share the corridor's cycle, each on its own offset;
+    // free-running ones start at independent points of the cycle
+    for (int i = 0; corridor != NULL && i < corridor->num_intersections; i++)
+    {
+        if (corridor->coordinated)
+        {
+            lights[i].coordination = &corridor->timing;
+            lights[i].offset = corridor->offset[i];
+        }
+        else
+        {
+            lights[i].start_phase = corridor->start_phase[i];
+        }
+    }
+
+    struct timespec wall_start;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    SimTime sim_start = clock_now(clock);
+
+    // Every shard thread writes its own ring; a virtual run waits for the
+    // flusher rather than lose records, as nothing can be late there
+    TraceLog log;
+    if (config->log_file != NULL)
+    {
+        result = trace_log_open(&log, config->log_file, config->plan, sim_start, num_threads,
+                                clock->mode == CLOCK_MODE_VIRTUAL);
+        if (result != SUCCESS)
+        {
+            goto cleanup;
+        }
+    }
+
+    // Lights resume from the state file of the previous run, if it matches
+    Snapshot snapshot;
+    if (config->state_file != NULL)
+    {
+        result = snapshot_open(&snapshot, config->state_file, config->plan, num_lights);
+        if (result != SUCCESS)
+        {
+            if (config->log_file != NULL)
+            {
+                trace_log_close(&log);
+            }
+            goto cleanup;
+        }
+    }
+
+    // Each shard replays the detections of its own lights, still in time order
+    int replayed = 0;
+
+    int initialized = 0;
+    for (int t = 0; t < num_threads && result == SUCCESS; t++)
+    {
+        int first = (int)((long)num_lights * t / num_threads);
+        int last = (int)((long)num_lights * (t + 1) / num_threads);
+        ControllerShard *shard = &shards[t];
+
+        result = init_shard(shard, clock, config->schedule, &lights[first], last - first, config->end,
+                            (config->log_file != NULL) ? &log.rings[t] : NULL,
+                            (config->state_file != NULL) ? &snapshot : NULL);
+        initialized++;
+        if (trace_id >= first && trace_id < last)
+        {
+            shard->button = &lights[trace_id];
+            shard->presses = config->presses;
+            shard->num_presses = config->num_presses;
+        }
+
+        if (config->num_replay > 0)
+        {
+            shard->replay = &replay[replayed];
+            for (int i = 0; i < config->num_replay; i++)
+            {
+                if (config->replay[i].intersection >= first && config->replay[i].intersection < last)
+                {
+                    replay[replayed++] = config->replay[i];
+                }
+            }
+            shard->num_replay = (int)(&replay[replayed] - shard->replay);
+        }
+
+        // Every approach with demand, and the button, is a source of arrivals
+        if (config->demand != NULL)
+        {
+            for (int i = first; i < last; i++)
+            {
+                for (int a = PEDESTRIAN_SOURCE; a < MAX_APPROACHES; a++)
+                {
+                    double rate = (a == PEDESTRIAN_SOURCE) ? config->demand->pedestrians_per_hour
+                                                           : config->demand->vehicles_per_hour[a];
+                    if (rate > 0.0 && enters_at(corridor, i, a))
+                    {
+                        TrafficSource *source = &sources[(size_t)i * (MAX_APPROACHES + 1) + (size_t)(a + 1)];
+                        traffic_source_init(source, i - first, i, a, rate, config->demand->seed, sim_start);
+                        timer_wheel_add(&shard->source_wheel, &source->timer, (uint64_t)(source->next / TIMER_TICK_NS));
+                    }
+                }
+            }
+        }
+
+        if (traffic)
+        {
+            shard->queues = &queues[(size_t)first * MAX_APPROACHES];
+            for (int i = first; i < last; i++)
+            {
+                for (int a = 0; a < MAX_APPROACHES; a++)
+                {
+                    vehicle_queue_init(&shard->queues[(size_t)(i - first) * MAX_APPROACHES + a], sim_start);
+                }
+                update_queues(shard, &lights[i], sim_start);
+            }
+        }
+
+        // The main street between the corridor's lights, both ways (all in this shard)
+        if (traffic && corridor != NULL && t == 0)
+        {
+            for (int i = 0; i + 1 < corridor->num_intersections && result == SUCCESS; i++)
+            {
+                SimTime travel = corridor_travel_time(corridor, i, i + 1);
+                result = vehicle_link_init(&links[num_links], &queues[(size_t)i * MAX_APPROACHES + MAIN_APPROACH],
+                                           i + 1, MAIN_APPROACH, travel);
+                num_links += (result == SUCCESS);
+                if (result == SUCCESS)
+                {
+                    result = vehicle_link_init(&links[num_links],
+                                               &queues[(size_t)(i + 1) * MAX_APPROACHES + OPPOSITE_APPROACH],
+                                               i, OPPOSITE_APPROACH, travel);
+                    num_links += (result == SUCCESS);
+                }
+            }
+            shard->links = links;
+            shard->num_links = num_links;
+        }
+    }
+
+    double startup = elapsed_seconds(&wall_start);
+    int started = 0;
+    for (int t = 0; t < num_threads && result == SUCCESS; t++)
+    {
+        if (pthread_create(&threads[t], NULL, shard_thread, &shards[t]) != 0)
+        {
+            fprintf(stderr, "Error: Cannot start controller thread %d\n", t);
+            result = UNKNOWN_ERROR;
+            break;
+        }
+        started++;
+    }
+
+    Grid grid = {
+        .lights = lights,
+        .num_lights = num_lights,
+        .shards = shards,
+        .num_shards = num_threads,
+        .clock = clock,
+        .default_light = (trace_id >= 0 && trace_id < num_lights) ? trace_id : 0,
+    };
+    int readers_started = 0;
+    for (int i = 0; i < config->num_inputs && result == SUCCESS; i++)
+    {
+        result = start_input_reader(&readers[i], &grid, config->input_fds[i]);
+        if (result == SUCCESS)
+        {
+            readers_started++;
+        }
+    }
+
+    // Shards that run forever would never be joined if the rest failed to start
+    for (int t = 0; t < started && result != SUCCESS; t++)
+    {
+        stop_shard(&shards[t]);
+    }
+
+    ShardStats total = {0};
+    long merged = 0;
+    long dropped = 0;
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(threads[t], NULL);
+        if (result == SUCCESS)
+        {
+            result = shards[t].result;
+        }
+    }
+    for (int i = 0; i < readers_started; i++)
+    {
+        stop_input_reader(&readers[i]);
+    }
+
+    for (int t = 0; t < initialized; t++)
+    {
+        const ShardStats *stats = &shards[t].stats;
+        total.timers += stats->timers;
+        total.transitions += stats->transitions;
+        total.presses += stats->presses;
+        total.total_lateness += stats->total_lateness;
+        total.inputs += stats->inputs;
+        total.vehicles_arrived += stats->vehicles_arrived;
+        total.vehicles_served += stats->vehicles_served;
+        total.vehicle_wait += stats->vehicle_wait;
+        total.active_queues += stats->active_queues;
+        for (int a = 0; a < MAX_APPROACHES; a++)
+        {
+            total.entered[a] += stats->entered[a];
+            total.stops[a] += stats->stops[a];
+            total.green[a] += stats->green[a];
+        }
+        total.pedestrians += stats->pedestrians;
+        total.joined += stats->joined;
+        total.resumed += stats->resumed;
+        total.requests_served += stats->requests_served;
+        total.requests_deferred += stats->requests_deferred;
+        total.total_deferred_wait += stats->total_deferred_wait;
+        total.total_request_wait += stats->total_request_wait;
+        if (stats->max_request_wait > total.max_request_wait)
+        {
+            total.max_request_wait = stats->max_request_wait;
+        }
+        for (int i = 0; i < PEDESTRIAN_WAIT_BUCKETS; i++)
+        {
+            total.request_wait_histogram[i] += stats->request_wait_histogram[i];
+        }
+        if (stats->max_queue > total.max_queue)
+        {
+            total.max_queue = stats->max_queue;
+        }
+        total.total_input_latency += stats->total_input_latency;
+        if (stats->max_lateness > total.max_lateness)
+        {
+            total.max_lateness = stats->max_lateness;
+        }
+        if (stats->max_input_latency > total.max_input_latency)
+        {
+            total.max_input_latency = stats->max_input_latency;
+        }
+        for (int i = 0; i < LATENCY_BUCKETS; i++)
+        {
+            total.input_latency_histogram[i] += stats->input_latency_histogram[i];
+        }
+        merged += atomic_load(&shards[t].merged);
+        dropped += (long)atomic_load(&shards[t].queue.dropped);
+
+        if (shards[t].wake_fd >= 0)
+        {
+            close(shards[t].wake_fd);
+        }
+    }
+
+    if (config->log_file != NULL)
+    {
+        int log_result = trace_log_close(&log);
+        if (result == SUCCESS)
+        {
+            result = log_result;
+        }
+    }
+
+    if (config->state_file != NULL)
+    {
+        int state_result = snapshot_close(&snapshot);
+        if (result == SUCCESS)
+        {
+            result = state_result;
+        }
+    }
+
+    if (result == SUCCESS &&
+        (num_lights > 1 || total.inputs > 0 || config->log_file != NULL || config->state_file != NULL || traffic))
+    {
+        print_summary(config, num_threads, &total, merged, dropped, &log, elapsed_seconds(&wall_start), sim_start,
+                      startup);
+    }
+
+cleanup:
+    for (int i = 0; i < num_links; i++)
+    {
+        vehicle_link_free(&links[i]);
+    }
+    free(links);
+    free(sources);
+    free(replay);
+    free(queues);
+    free(shards);
+    free(lights);
+    return result;
+}
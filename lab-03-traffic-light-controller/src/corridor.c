@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "corridor.h"
+#include "error_codes.h"
+#include "parse.h"
+
+#define OFFSET_STEP (NS_PER_SECOND / 10) // Resolution of the offset search
+#define OPTIMIZER_STARTS 64              // Starting points of the search, most of them random
+#define NS_PER_MS (NS_PER_SECOND / 1000)
+#define MAX_POSITION 1e6           // Metres along the street either way
+#define MAX_OFFSET (24.0 * 3600.0) // Seconds either way
+#define MAX_SPEED 300.0            // Design speed, km/h
+
+// 'time' folded into [0, cycle)
+static SimTime cycle_position(SimTime time, SimTime cycle)
+{
+    SimTime position = time % cycle;
+    return (position < 0) ? position + cycle : position;
+}
+
+// Step of a xorshift64 generator; the state must not be zero
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state;
+}
+
+// Parse one 'intersection METRES [OFFSET_SECONDS]' line
+static int parse_intersection(Corridor *corridor, char **save, int *num_offsets)
+{
+    const char *position = strtok_r(NULL, " \t\r\n", save);
+    const char *offset = strtok_r(NULL, " \t\r\n", save);
+    int i = corridor->num_intersections;
+    if (position == NULL || i == MAX_CORRIDOR_LENGTH)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    if (!parse_double(position, -MAX_POSITION, MAX_POSITION, &corridor->position[i]) ||
+        (i > 0 && corridor->position[i] <= corridor->position[i - 1]))
+    {
+        return INVALID_ARGUMENT; // Listed along the street
+    }
+    if (offset != NULL)
+    {
+        double seconds;
+        if (!parse_double(offset, -MAX_OFFSET, MAX_OFFSET, &seconds))
+        {
+            return INVALID_ARGUMENT;
+        }
+        corridor->offset[i] = (SimTime)llround(seconds * 1000.0) * NS_PER_MS;
+        (*num_offsets)++;
+    }
+
+    corridor->num_intersections++;
+    return SUCCESS;
+}
+
+/*
+ * Function: load_corridor
+ * -----------------------------
+ * Reads a corridor from a text file. Each line is one of
+ *
+ *   speed KM_PER_HOUR
+ *   intersection METRES [OFFSET_SECONDS]
+ *
+ * The intersections are numbered 0, 1, ... in the order of their lines, which
+ * is their order along the main street. Either every intersection has an
+ * offset or none has, and then optimize_offsets() finds them. Empty lines and
+ * lines starting with '#' are ignored.
+ *
+ * Returns:
+ * - SUCCESS if the corridor has a speed and at least two intersections.
+ * - INVALID_ARGUMENT if the file cannot be read or is invalid.
+ */
+int load_corridor(const char *filename, Corridor *corridor)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror("Error opening corridor");
+        return INVALID_ARGUMENT;
+    }
+
+    memset(corridor, 0, sizeof(*corridor));
+    corridor->coordinated = true;
+
+    char line[256];
+    int line_number = 0;
+    int num_offsets = 0;
+    int result = SUCCESS;
+    while (result == SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+
+        char *save;
+        const char *keyword = strtok_r(line, " \t\r\n", &save);
+        if (keyword == NULL || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        if (strcmp(keyword, "speed") == 0)
+        {
+            const char *speed = strtok_r(NULL, " \t\r\n", &save);
+            double km_per_hour = 0.0;
+            result = (parse_double(speed, 0.0, MAX_SPEED, &km_per_hour) && km_per_hour > 0.0) ? SUCCESS : INVALID_ARGUMENT;
+            corridor->speed = km_per_hour / 3.6;
+        }
+        else if (strcmp(keyword, "intersection") == 0)
+        {
+            result = parse_intersection(corridor, &save, &num_offsets);
+        }
+        else
+        {
+            result = INVALID_ARGUMENT;
+        }
+    }
+
+    fclose(file);
+
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Invalid line %d in corridor %s\n", line_number, filename);
+        return result;
+    }
+
+    if (corridor->speed <= 0.0 || corridor->num_intersections < 2 ||
+        (num_offsets != 0 && num_offsets != corridor->num_intersections))
+    {
+        fprintf(stderr, "Error: Corridor %s needs a speed, two intersections or more, and offsets for all or none\n",
+                filename);
+        return INVALID_ARGUMENT;
+    }
+
+    corridor->has_offsets = (num_offsets > 0);
+    return SUCCESS;
+}
+
+/*
+ * Function: corridor_timing
+ * -----------------------------
+ * Follows the plan's timer transitions from its initial state around the day
+ * cycle. The cycle length is the common cycle of the corridor, the first
+ * state serving the main street is the coordinated green, and the longest
+ * state serving neither main-street approach is the one a coordinated light
+ * stretches or cuts to stay on its offset. Offsets read from the file are
+ * folded into the cycle.
+ *
+ * Returns:
+ * - SUCCESS with corridor->timing set.
+ * - INVALID_ARGUMENT if the plan has no fixed cycle with a main-street green.
+ */
+int corridor_timing(Corridor *corridor, const PhasePlan *plan)
+{
+    int states[MAX_PLAN_STATES];
+    SimTime lengths[MAX_PLAN_STATES];
+    int count = 0;
+    int state = plan->initial;
+    do
+    {
+        const Transition *transition = &plan->table[state][EVENT_TIMER];
+        if (count == MAX_PLAN_STATES || transition->duration <= 0)
+        {
+            fprintf(stderr, "Error: The day cycle of the phase plan does not return to its initial state\n");
+            return INVALID_ARGUMENT;
+        }
+        state = transition->next;
+        states[count] = state;
+        lengths[count] = (SimTime)transition->duration * NS_PER_SECOND;
+        count++;
+    } while (state != plan->initial);
+
+    uint8_t main_street = (1 << MAIN_APPROACH) | (1 << OPPOSITE_APPROACH);
+    int green = -1;
+    for (int i = 0; i < count && green < 0; i++)
+    {
+        if (plan->serves[states[i]] & (1 << MAIN_APPROACH))
+        {
+            green = i;
+        }
+    }
+
+    Coordination *timing = &corridor->timing;
+    timing->cycle = 0;
+    timing->sync_state = -1;
+    SimTime sync_length = 0;
+    for (int k = 0; green >= 0 && k < count; k++)
+    {
+        int i = (green + k) % count;
+        if (!(plan->serves[states[i]] & main_street) && lengths[i] > sync_length)
+        {
+            sync_length = lengths[i];
+            timing->sync_state = states[i];
+            timing->sync_end = timing->cycle + lengths[i];
+        }
+        timing->cycle += lengths[i];
+    }
+
+    if (timing->sync_state < 0)
+    {
+        fprintf(stderr, "Error: The day cycle of the phase plan needs a main-street green and a phase without it\n");
+        return INVALID_ARGUMENT;
+    }
+
+    timing->green = lengths[green];
+    for (int i = 0; i < corridor->num_intersections; i++)
+    {
+        corridor->offset[i] = cycle_position(corridor->offset[i], timing->cycle);
+    }
+
+    return SUCCESS;
+}
+
+SimTime corridor_travel_time(const Corridor *corridor, int from, int to)
+{
+    double seconds = fabs(corridor->position[to] - corridor->position[from]) / corridor->speed;
+    return (SimTime)llround(seconds * 1000.0) * NS_PER_MS;
+}
+
+/*
+ * Function: corridor_bandwidth
+ * -----------------------------
+ * The green band of one direction: how much of the green at the first
+ * intersection it meets can be used by vehicles that then find every
+ * following light green at the design speed.
+ *
+ * A departure u seconds into the first green reaches intersection i when its
+ * green has been on for (u - d) mod cycle, where d is i's green start in the
+ * first's timing. Each intersection therefore blocks one stretch of the first
+ * green, and the band is the longest stretch left free.
+ */
+SimTime corridor_bandwidth(const Corridor *corridor, int direction)
+{
+    const Coordination *timing = &corridor->timing;
+    int first = (direction == OUTBOUND) ? 0 : corridor->num_intersections - 1;
+    SimTime from[MAX_CORRIDOR_LENGTH];
+    SimTime to[MAX_CORRIDOR_LENGTH];
+    int blocked = 0;
+
+    for (int i = 0; i < corridor->num_intersections; i++)
+    {
+        SimTime d = cycle_position(corridor->offset[i] - corridor->offset[first] -
+                                   corridor_travel_time(corridor, first, i), timing->cycle);
+        SimTime start = (d + timing->green > timing->cycle) ? d + timing->green - timing->cycle : 0;
+        SimTime end = (d < timing->green) ? d : timing->green;
+        if (start >= end)
+        {
+            continue;
+        }
+
+        // Keep the stretches sorted by their start
+        int k = blocked++;
+        while (k > 0 && from[k - 1] > start)
+        {
+            from[k] = from[k - 1];
+            to[k] = to[k - 1];
+            k--;
+        }
+        from[k] = start;
+        to[k] = end;
+    }
+
+    SimTime band = 0;
+    SimTime covered = 0;
+    for (int k = 0; k < blocked; k++)
+    {
+        if (from[k] - covered > band)
+        {
+            band = from[k] - covered;
+        }
+        if (to[k] > covered)
+        {
+            covered = to[k];
+        }
+    }
+
+    return (timing->green - covered > band) ? timing->green - covered : band;
+}
+
+// Both bands together, with the narrower one counted twice: one wide band
+// and none the other way is worth less than two fair ones
+static SimTime band_score(const Corridor *corridor)
+{
+    SimTime outbound = corridor_bandwidth(corridor, OUTBOUND);
+    SimTime inbound = corridor_bandwidth(corridor, INBOUND);
+    return outbound + inbound + ((outbound < inbound) ? outbound : inbound);
+}
+
+// Move one offset at a time to its best position for as long as the score
+// of the bands grows. Returns that score.
+static SimTime improve_offsets(Corridor *corridor)
+{
+    SimTime best = band_score(corridor);
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+        for (int i = 1; i < corridor->num_intersections; i++)
+        {
+            SimTime keep = corridor->offset[i];
+            for (SimTime offset = 0; offset < corridor->timing.cycle; offset += OFFSET_STEP)
+            {
+                corridor->offset[i] = offset;
+                SimTime band = band_score(corridor);
+                if (band > best)
+                {
+                    best = band;
+                    keep = offset;
+                    improved = true;
+                }
+            }
+            corridor->offset[i] = keep;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Function: optimize_offsets
+ * -----------------------------
+ * Searches the offsets that give the widest green bands in both directions
+ * at the design speed. A progression for one direction alone is easy (each
+ * offset is the travel time from the first light), but it usually leaves
+ * nothing for the other direction, so the search maximizes the sum of both
+ * bands with the narrower one counted twice. The search starts from the
+ * progression of each direction, from alternating offsets and from random
+ * offsets (always the same ones), improves each start one intersection at a
+ * time in steps of OFFSET_STEP, and keeps the best result. Intersection 0
+ * keeps offset 0.
+ */
+void optimize_offsets(Corridor *corridor)
+{
+    const Coordination *timing = &corridor->timing;
+    int n = corridor->num_intersections;
+    SimTime best[MAX_CORRIDOR_LENGTH];
+    SimTime best_band = -1;
+    uint64_t random = 0x9E3779B97F4A7C15ULL;
+
+    for (int start = 0; start < OPTIMIZER_STARTS; start++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            SimTime travel = corridor_travel_time(corridor, 0, i);
+            SimTime offset = (start == 0) ? travel : (start == 1) ? -travel : (i % 2) * (timing->cycle / 2);
+            if (start > 2 && i > 0)
+            {
+                offset = (SimTime)(next_random(&random) % (uint64_t)timing->cycle);
+            }
+            corridor->offset[i] = cycle_position(offset, timing->cycle) / OFFSET_STEP * OFFSET_STEP;
+        }
+
+        SimTime band = improve_offsets(corridor);
+        if (band > best_band)
+        {
+            best_band = band;
+            memcpy(best, corridor->offset, (size_t)n * sizeof(SimTime));
+        }
+    }
+
+    memcpy(corridor->offset, best, (size_t)n * sizeof(SimTime));
+}
+
+/*
+ * Function: randomize_start_phases
+ * -----------------------------
+ * Gives each light a start phase drawn uniformly from the cycle, for running
+ * the corridor uncoordinated. Controllers that were switched on independently
+ * have no relation between their cycles; starting them all together would
+ * compare the coordination with zero offsets instead. The same seed gives the
+ * same phases.
+ */
+void randomize_start_phases(Corridor *corridor, uint64_t seed)
+{
+    uint64_t random = (seed != 0x9E3779B97F4A7C15ULL) ? seed ^ 0x9E3779B97F4A7C15ULL : 1;
+    for (int i = 0; i < corridor->num_intersections; i++)
+    {
+        SimTime phase = (SimTime)(next_random(&random) % (uint64_t)(corridor->timing.cycle / NS_PER_MS));
+        corridor->start_phase[i] = phase * NS_PER_MS;
+    }
+}
+
+void print_corridor(const Corridor *corridor)
+{
+    const Coordination *timing = &corridor->timing;
+    printf("Corridor: %d intersections, cycle %.0f s, main-street green %.0f s, design speed %.0f km/h\n",
+           corridor->num_intersections, (double)timing->cycle / NS_PER_SECOND,
+           (double)timing->green / NS_PER_SECOND, corridor->speed * 3.6);
+
+    if (!corridor->coordinated)
+    {
+        printf("Offsets: none, the lights run free from random start phases:");
+        for (int i = 0; i < corridor->num_intersections; i++)
+        {
+            printf(" %.1f", (double)corridor->start_phase[i] / NS_PER_SECOND);
+        }
+        printf(" s\n");
+        return;
+    }
+
+    printf("Offsets:");
+    for (int i = 0; i < corridor->num_intersections; i++)
+    {
+        printf(" %.1f", (double)corridor->offset[i] / NS_PER_SECOND);
+    }
+    printf(" s\nGreen band: outbound %.1f s, inbound %.1f s\n",
+           (double)corridor_bandwidth(corridor, OUTBOUND) / NS_PER_SECOND,
+           (double)corridor_bandwidth(corridor, INBOUND) / NS_PER_SECOND);
+}
@@ -0,0 +1,62 @@
+#include "event_queue.h"
+
+#define QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+void event_queue_init(EventQueue *queue)
+{
+    for (size_t i = 0; i < EVENT_QUEUE_SIZE; i++)
+    {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->dropped, 0);
+    queue->head = 0;
+}
+
+bool event_queue_push(EventQueue *queue, const InputEvent *event)
+{
+    size_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    while (1)
+    {
+        EventSlot *slot = &queue->slots[position & QUEUE_MASK];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if (difference == 0)
+        {
+            // The slot is free: claim the position (on failure 'position' is reloaded)
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                slot->event = *event;
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The consumer has not freed this slot yet: the queue is full
+            atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&queue->tail, memory_order_relaxed); // Another producer was faster
+        }
+    }
+}
+
+bool event_queue_pop(EventQueue *queue, InputEvent *event)
+{
+    EventSlot *slot = &queue->slots[queue->head & QUEUE_MASK];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != queue->head + 1)
+    {
+        return false; // Empty, or the producer of this slot has not finished writing
+    }
+
+    *event = slot->event;
+    atomic_store_explicit(&slot->sequence, queue->head + EVENT_QUEUE_SIZE, memory_order_release);
+    queue->head++;
+    return true;
+}
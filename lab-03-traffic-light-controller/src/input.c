@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "input.h"
+#include "error_codes.h"
+
+#define INPUT_LINE_LENGTH 128
+
+/*
+ * Function: parse_input_line
+ * -----------------------------
+ * Parses one line of an input source. A plain 'b' (as typed at the terminal)
+ * is a press of the default intersection's button.
+ *
+ * Returns:
+ * - SUCCESS with the event in 'type', 'intersection' and 'value'.
+ * - INVALID_ARGUMENT for an empty or unknown line.
+ */
+int parse_input_line(const char *line, int default_light, InputType *type, int *intersection, int *value)
+{
+    char command[16] = "";
+    char argument[16] = "";
+    int id = default_light;
+    int fields = sscanf(line, "%15s %d %15s", command, &id, argument);
+    if (fields < 1 || command[1] != '\0')
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    *intersection = id;
+    *value = 0;
+
+    switch (command[0])
+    {
+    case 'b':
+    case 'B':
+        *type = INPUT_PEDESTRIAN;
+        return SUCCESS;
+
+    case 'd':
+        *type = INPUT_DETECTOR;
+        if (fields == 3)
+        {
+            char *end;
+            *value = (int)strtol(argument, &end, 10);
+            if (*end != '\0' || *value < 0 || *value >= MAX_APPROACHES)
+            {
+                return INVALID_ARGUMENT;
+            }
+        }
+        return (fields >= 2) ? SUCCESS : INVALID_ARGUMENT;
+
+    case 'o':
+        *type = INPUT_OVERRIDE;
+        if (fields < 3)
+        {
+            return INVALID_ARGUMENT;
+        }
+        if (strcmp(argument, "auto") == 0)
+        {
+            *value = -1;
+            return SUCCESS;
+        }
+        for (int mode = MODE_DAY; mode <= MODE_NIGHT; mode++)
+        {
+            if (strcmp(argument, day_mode_name((DayMode)mode)) == 0)
+            {
+                *value = mode;
+                return SUCCESS;
+            }
+        }
+        return INVALID_ARGUMENT;
+
+    default:
+        return INVALID_ARGUMENT;
+    }
+}
+
+/*
+ * Function: load_detector_replay
+ * -----------------------------
+ * Reads recorded detector events, one per line:
+ *
+ *   SECONDS,INTERSECTION,APPROACH
+ *
+ * SECONDS is the time after 'start' and may have a fraction; the lines must
+ * be in time order. Empty lines and lines starting with '#' are ignored.
+ *
+ * Returns:
+ * - SUCCESS with a malloc'ed array of INPUT_DETECTOR events in 'events'.
+ * - INVALID_ARGUMENT if the file cannot be read or a line is invalid.
+ * - UNKNOWN_ERROR if memory runs out.
+ */
+int load_detector_replay(const char *filename, SimTime start, InputEvent **events, int *count)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror("Error opening detector replay");
+        return INVALID_ARGUMENT;
+    }
+
+    InputEvent *list = NULL;
+    int used = 0;
+    int capacity = 0;
+    char line[INPUT_LINE_LENGTH];
+    int line_number = 0;
+    int result = SUCCESS;
+    while (result == SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+        {
+            continue;
+        }
+
+        double seconds;
+        int intersection, approach;
+        if (sscanf(line, "%lf,%d,%d", &seconds, &intersection, &approach) != 3 || seconds < 0.0 ||
+            intersection < 0 || approach < 0 || approach >= MAX_APPROACHES)
+        {
+            result = INVALID_ARGUMENT;
+            break;
+        }
+
+        SimTime time = start + (SimTime)(seconds * NS_PER_SECOND);
+        if (used > 0 && time < list[used - 1].time)
+        {
+            result = INVALID_ARGUMENT; // Not in time order
+            break;
+        }
+
+        if (used == capacity)
+        {
+            capacity = (capacity == 0) ? 1024 : capacity * 2;
+            InputEvent *grown = realloc(list, (size_t)capacity * sizeof(InputEvent));
+            if (grown == NULL)
+            {
+                result = UNKNOWN_ERROR;
+                break;
+            }
+            list = grown;
+        }
+
+        list[used++] = (InputEvent){
+            .time = time,
+            .intersection = intersection,
+            .value = approach,
+            .type = INPUT_DETECTOR,
+        };
+    }
+
+    fclose(file);
+
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Invalid line %d in detector replay %s\n", line_number, filename);
+        free(list);
+        return result;
+    }
+
+    *events = list;
+    *count = used;
+    return SUCCESS;
+}
+
+static void handle_line(InputReader *reader, const char *line)
+{
+    InputType type;
+    int intersection, value;
+    if (parse_input_line(line, reader->grid->default_light, &type, &intersection, &value) != SUCCESS)
+    {
+        if (line[0] != '\0')
+        {
+            fprintf(stderr, "Error: Unknown input: %s\n", line);
+        }
+        return;
+    }
+
+    // Queueing is not interrupted half-way by stop_input_reader()
+    int state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+    if (submit_input(reader->grid, type, intersection, value) == INVALID_ARGUMENT)
+    {
+        fprintf(stderr, "Error: No intersection %d\n", intersection);
+    }
+    pthread_setcancelstate(state, NULL);
+}
+
+// Input thread: a blocking read() per chunk, split into lines. The thread only
+// produces events; the shard threads apply them.
+static void *reader_thread(void *arg)
+{
+    InputReader *reader = arg;
+    char buffer[INPUT_LINE_LENGTH];
+    size_t used = 0;
+
+    while (1)
+    {
+        ssize_t length = read(reader->fd, buffer + used, sizeof(buffer) - 1 - used);
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (length <= 0)
+        {
+            break; // End of input: the controller keeps running without it
+        }
+        used += (size_t)length;
+        buffer[used] = '\0';
+
+        char *start = buffer;
+        char *newline;
+        while ((newline = strchr(start, '\n')) != NULL)
+        {
+            *newline = '\0';
+            handle_line(reader, start);
+            start = newline + 1;
+        }
+
+        // Keep the unfinished line; one that fills the whole buffer is dropped
+        used = (size_t)(buffer + used - start);
+        if (used == sizeof(buffer) - 1)
+        {
+            used = 0;
+        }
+        memmove(buffer, start, used);
+    }
+
+    if (used > 0)
+    {
+        buffer[used] = '\0';
+        handle_line(reader, buffer);
+    }
+
+    return NULL;
+}
+
+int start_input_reader(InputReader *reader, Grid *grid, int fd)
+{
+    reader->grid = grid;
+    reader->fd = fd;
+
+    if (pthread_create(&reader->thread, NULL, reader_thread, reader) != 0)
+    {
+        perror("Error starting input thread");
+        return UNKNOWN_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+void stop_input_reader(InputReader *reader)
+{
+    pthread_cancel(reader->thread); // Blocked in read(), a cancellation point
+    pthread_join(reader->thread, NULL);
+}
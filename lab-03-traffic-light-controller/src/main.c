@@ -1,19 +1,380 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "traffic_light.h"
+#include "controller.h"
+#include "clock.h"
+#include "input.h"
 #include "error_codes.h"
+#include "parse.h"
 
-int main(void)
+#define DEFAULT_VIRTUAL_DURATION (24 * 3600) // One simulated day
+
+// Scripted button presses for the virtual clock
+typedef struct
+{
+    SimTime *times;
+    int count;
+    int capacity;
+} PressList;
+
+static int add_press(PressList *list, SimTime time)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = (list->capacity == 0) ? 64 : list->capacity * 2;
+        SimTime *times = realloc(list->times, (size_t)capacity * sizeof(SimTime));
+        if (times == NULL)
+        {
+            return UNKNOWN_ERROR;
+        }
+        list->times = times;
+        list->capacity = capacity;
+    }
+
+    list->times[list->count++] = time;
+    return SUCCESS;
+}
+
+// Button script: one press per line, given in seconds after the start of the
+// run. Empty lines and lines starting with '#' are ignored.
+static int load_script(PressList *list, const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror("Error opening button script");
+        return INVALID_ARGUMENT;
+    }
+
+    char line[128];
+    int result = SUCCESS;
+    while (result == SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        char *end;
+        double offset = strtod(line, &end);
+        if (end == line)
+        {
+            if (line[0] != '#' && line[0] != '\n')
+            {
+                fprintf(stderr, "Error: Invalid line in button script: %s", line);
+                result = INVALID_ARGUMENT;
+            }
+            continue;
+        }
+        result = add_press(list, (SimTime)(offset * NS_PER_SECOND));
+    }
+
+    fclose(file);
+    return result;
+}
+
+static int compare_times(const void *a, const void *b)
+{
+    SimTime x = *(const SimTime *)a;
+    SimTime y = *(const SimTime *)b;
+    return (x > y) - (x < y);
+}
+
+// Open an input source. A FIFO is opened for writing as well, so that it
+// neither blocks until a writer appears nor reports end of input when one leaves.
+static int open_input(const char *path)
+{
+    struct stat info;
+    int flags = (stat(path, &info) == 0 && S_ISFIFO(info.st_mode)) ? O_RDWR : O_RDONLY;
+    int fd = open(path, flags);
+    if (fd < 0)
+    {
+        perror("Error opening input");
+    }
+
+    return fd;
+}
+
+// Close the sources opened with --input; standard input stays open
+static void close_inputs(const int *inputs, int num_inputs)
+{
+    for (int i = 1; i < num_inputs; i++)
+    {
+        if (inputs[i] >= 0)
+        {
+            close(inputs[i]);
+        }
+    }
+}
+
+static void print_usage(void)
+{
+    fprintf(stderr, "Usage: traffic_light [--speed N] [--virtual] [--start \"YYYY-MM-DD HH:MM:SS\"]\n"
+                    "                     [--duration SECONDS] [--press SECONDS] [--script FILE]\n"
+                    "                     [--intersections N] [--threads N] [--trace ID] [--plan FILE]\n"
+                    "                     [--schedule FILE] [--input FILE] [--log FILE] [--detectors FILE]\n"
+                    "                     [--corridor FILE] [--state FILE]\n"
+                    "  --speed N           Run N times faster than real time\n"
+                    "  --virtual           Simulate without waiting (discrete-event clock)\n"
+                    "  --start TIME        Simulated start time (local time)\n"
+                    "  --duration SECONDS  Length of the run (virtual default one day, otherwise forever)\n"
+                    "  --press SECONDS     Virtual button press, seconds after the start\n"
+                    "  --script FILE       Virtual button presses, one offset per line\n"
+                    "  --intersections N   Run N independent intersections (default 1)\n"
+                    "  --threads N         Worker threads, each owning a shard of the intersections\n"
+                    "  --trace ID          Intersection that is printed and has the button (default 0, -1 for none)\n"
+                    "  --plan FILE         Phase plan to run instead of the built-in one\n"
+                    "  --schedule FILE     Day/blink/night times per weekday and holiday\n"
+                    "  --input FILE        Extra input source (e.g. a FIFO), read like standard input:\n"
+                    "                      'b [ID]' button, 'd ID' detector, 'o ID day|blink|night|auto' override\n"
+                    "  --log FILE          Binary trace of every intersection (read it with trace_decode)\n"
+                    "  --detectors FILE    Virtual detector replay, 'SECONDS,INTERSECTION,APPROACH' per line,\n"
+                    "                      with a queue model that reports vehicles served and their wait\n"
+                    "  --corridor FILE     Coordinate the first intersections along a main street: common cycle,\n"
+                    "                      offsets from the file or optimized for its design speed\n"
+                    "  --state FILE        Keep the state of every light in FILE and resume from it on restart\n");
+}
+
+int main(int argc, char *argv[])
 {
     ErrorCode error_code;
 
-    error_code = init_traffic_light();
+    ClockMode mode = CLOCK_MODE_REAL;
+    double speed = 1.0;
+    SimTime start = -1; // Current time unless given
+    double duration = -1.0; // Default depends on the clock
+    int num_lights = 1;
+    int num_threads = 1;
+    int trace_id = 0;
+    const char *log_file = NULL;
+    const char *replay_file = NULL;
+    const char *corridor_file = NULL;
+    const char *state_file = NULL;
+    static Corridor corridor;
+    static PhasePlan loaded_plan;
+    const PhasePlan *plan = &default_phase_plan;
+    static Schedule loaded_schedule;
+    const Schedule *schedule = &default_schedule;
+    PressList presses = {0};
+    int inputs[MAX_INPUTS] = {STDIN_FILENO}; // Standard input is always a source
+    int num_inputs = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        int result = SUCCESS;
+
+        if (strcmp(argv[i], "--speed") == 0 && has_value)
+        {
+            bool valid = parse_double(argv[++i], 0.0, MAX_CLOCK_SPEED, &speed) && speed > 0.0;
+            result = valid ? SUCCESS : INVALID_ARGUMENT;
+            if (mode == CLOCK_MODE_REAL)
+            {
+                mode = CLOCK_MODE_SCALED;
+            }
+        }
+        else if (strcmp(argv[i], "--virtual") == 0)
+        {
+            mode = CLOCK_MODE_VIRTUAL;
+        }
+        else if (strcmp(argv[i], "--start") == 0 && has_value)
+        {
+            result = clock_parse(argv[++i], &start);
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && has_value)
+        {
+            bool valid = parse_double(argv[++i], 0.0, MAX_RUN_SECONDS, &duration) && duration > 0.0;
+            result = valid ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--intersections") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], 1, INT_MAX, &num_lights) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], 1, MAX_CONTROLLER_THREADS, &num_threads) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], -1, INT_MAX, &trace_id) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--detectors") == 0 && has_value)
+        {
+            replay_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--corridor") == 0 && has_value)
+        {
+            corridor_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--log") == 0 && has_value)
+        {
+            log_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--state") == 0 && has_value)
+        {
+            state_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--plan") == 0 && has_value)
+        {
+            result = load_phase_plan(argv[++i], &loaded_plan);
+            plan = &loaded_plan;
+        }
+        else if (strcmp(argv[i], "--schedule") == 0 && has_value)
+        {
+            result = load_schedule(argv[++i], &loaded_schedule);
+            schedule = &loaded_schedule;
+        }
+        else if (strcmp(argv[i], "--input") == 0 && has_value && num_inputs == MAX_INPUTS)
+        {
+            fprintf(stderr, "Error: Too many inputs (at most %d besides standard input)\n", MAX_INPUTS - 1);
+            result = INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--input") == 0 && has_value)
+        {
+            inputs[num_inputs] = open_input(argv[++i]);
+            result = (inputs[num_inputs++] >= 0) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--press") == 0 && has_value)
+        {
+            double seconds;
+            result = parse_double(argv[++i], 0.0, MAX_RUN_SECONDS, &seconds) ? SUCCESS : INVALID_ARGUMENT;
+            if (result == SUCCESS)
+            {
+                result = add_press(&presses, (SimTime)(seconds * NS_PER_SECOND));
+            }
+        }
+        else if (strcmp(argv[i], "--script") == 0 && has_value)
+        {
+            result = load_script(&presses, argv[++i]);
+        }
+        else
+        {
+            result = INVALID_ARGUMENT;
+        }
+
+        if (result != SUCCESS)
+        {
+            print_usage();
+            free(presses.times);
+            close_inputs(inputs, num_inputs);
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    if (num_inputs > 1 && mode == CLOCK_MODE_VIRTUAL)
+    {
+        fprintf(stderr, "Error: --input needs a real or scaled clock, use --press with --virtual.\n");
+        free(presses.times);
+        close_inputs(inputs, num_inputs);
+        return INVALID_ARGUMENT;
+    }
+
+    if ((presses.count > 0 || replay_file != NULL) && mode != CLOCK_MODE_VIRTUAL)
+    {
+        fprintf(stderr, "Error: Scripted button presses and detector replays need --virtual.\n");
+        free(presses.times);
+        close_inputs(inputs, num_inputs);
+        return INVALID_ARGUMENT;
+    }
+
+    // Every controller derives the same cycle and offsets from the same files
+    if (corridor_file != NULL)
+    {
+        error_code = load_corridor(corridor_file, &corridor);
+        if (error_code == SUCCESS)
+        {
+            error_code = corridor_timing(&corridor, plan);
+        }
+        if (error_code != SUCCESS)
+        {
+            free(presses.times);
+            close_inputs(inputs, num_inputs);
+            return error_code;
+        }
+        if (!corridor.has_offsets)
+        {
+            optimize_offsets(&corridor);
+        }
+        if (num_lights < corridor.num_intersections)
+        {
+            num_lights = corridor.num_intersections;
+        }
+        print_corridor(&corridor);
+    }
+
+    if (trace_id < -1 || trace_id >= num_lights)
+    {
+        fprintf(stderr, "Error: No intersection %d to trace (0 to %d, or -1 for none)\n", trace_id, num_lights - 1);
+        free(presses.times);
+        close_inputs(inputs, num_inputs);
+        return INVALID_ARGUMENT;
+    }
+
+    if (mode == CLOCK_MODE_REAL && start >= 0)
+    {
+        mode = CLOCK_MODE_SCALED; // A different start time needs a simulated clock
+    }
+
+    if (mode == CLOCK_MODE_VIRTUAL && duration < 0.0)
+    {
+        duration = DEFAULT_VIRTUAL_DURATION;
+    }
+
+    Clock clock;
+    error_code = clock_init(&clock, mode, speed, start);
     if (error_code != SUCCESS)
     {
         fprintf(stderr, "Error: Failed to initialize traffic light (Error Code: %d)\n", error_code);
+        free(presses.times);
+        close_inputs(inputs, num_inputs);
         return error_code;
     }
 
-    error_code = run_traffic_light();
+    // Script offsets are relative to the start
+    for (int i = 0; i < presses.count; i++)
+    {
+        presses.times[i] += clock.start;
+    }
+    qsort(presses.times, (size_t)presses.count, sizeof(SimTime), compare_times);
+
+    InputEvent *replay = NULL;
+    int num_replay = 0;
+    if (replay_file != NULL)
+    {
+        error_code = load_detector_replay(replay_file, clock.start, &replay, &num_replay);
+        if (error_code != SUCCESS)
+        {
+            free(presses.times);
+            close_inputs(inputs, num_inputs);
+            return error_code;
+        }
+    }
+
+    GridConfig config = {
+        .clock = &clock,
+        .plan = plan,
+        .schedule = schedule,
+        .num_lights = num_lights,
+        .num_threads = num_threads,
+        .end = (duration < 0.0) ? -1 : clock.start + (SimTime)(duration * NS_PER_SECOND),
+        .trace_id = trace_id,
+        .presses = presses.times,
+        .num_presses = presses.count,
+        .input_fds = inputs,
+        .num_inputs = (mode == CLOCK_MODE_VIRTUAL) ? 0 : num_inputs, // A virtual run has its script instead
+        .log_file = log_file,
+        .replay = replay,
+        .num_replay = num_replay,
+        .corridor = (corridor_file != NULL) ? &corridor : NULL,
+        .state_file = state_file,
+    };
+    error_code = run_grid(&config);
+
+    free(presses.times);
+    close_inputs(inputs, num_inputs);
+    free(replay);
+
     if (error_code != SUCCESS)
     {
         fprintf(stderr, "Error: Failed to run traffic light (Error Code: %d)\n", error_code);
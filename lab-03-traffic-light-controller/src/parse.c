@@ -0,0 +1,42 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+#include "parse.h"
+
+bool parse_int(const char *text, int min, int max, int *value)
+{
+    if (text == NULL)
+    {
+        return false;
+    }
+
+    char *end;
+    errno = 0;
+    long number = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || number < min || number > max)
+    {
+        return false;
+    }
+
+    *value = (int)number;
+    return true;
+}
+
+bool parse_double(const char *text, double min, double max, double *value)
+{
+    if (text == NULL)
+    {
+        return false;
+    }
+
+    char *end;
+    errno = 0;
+    double number = strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !isfinite(number) || number < min || number > max)
+    {
+        return false;
+    }
+
+    *value = number;
+    return true;
+}
@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "phase_plan.h"
+#include "traffic_light.h"
+#include "error_codes.h"
+#include "parse.h"
+
+#define MAX_PLAN_SECONDS (24 * 3600) // Longest phase, extension or wait in a plan file
+
+// Announcements of the built-in plan
+enum
+{
+    NO_MESSAGE,
+    BLINK_MESSAGE,
+    NIGHT_MESSAGE,
+    PEDESTRIAN_MESSAGE
+};
+
+// Cells shared by the day states
+#define START_BLINK {BLINKING_YELLOW, 0, BLINK_MESSAGE, 1}
+#define START_NIGHT {OFF, 0, NIGHT_MESSAGE, DURATION_UNTIL_MODE_CHANGE}
+#define PEDESTRIAN_GREEN {GREEN, TRANSITION_SERVE, PEDESTRIAN_MESSAGE, 15}
+
+// Day cycle RED (10 s) -> RED+YELLOW (2 s) -> GREEN (15 s) -> YELLOW (2 s).
+// Pedestrians cross with GREEN, so a press during GREEN joins them; any
+// other press cuts RED short once it has run 5 s and is served by the next
+// GREEN. The yellow blinks once per second before night and before morning,
+// and the night stays OFF until the schedule changes the mode. The timing is
+// fixed; while the light blinks or is off, drivers of every approach give way.
+const PhasePlan default_phase_plan = {
+    .num_states = 6,
+    .initial = RED,
+    .initial_duration = 10,
+    .num_messages = 4,
+    .state_names = {
+        [RED] = "RED",
+        [YELLOW] = "YELLOW",
+        [GREEN] = "GREEN",
+        [RED_YELLOW] = "RED+YELLOW",
+        [BLINKING_YELLOW] = "BLINKING YELLOW",
+        [OFF] = "OFF",
+    },
+    .messages = {
+        [NO_MESSAGE] = "",
+        [BLINK_MESSAGE] = "Transition Period: Switching to BLINKING YELLOW.",
+        [NIGHT_MESSAGE] = "Night Period: Traffic Light is OFF.",
+        [PEDESTRIAN_MESSAGE] = "Pedestrian requested green light. Switching to GREEN for pedestrian.",
+    },
+    .table = {
+        //                    EVENT_TIMER                   EVENT_PEDESTRIAN              EVENT_BLINK                    EVENT_NIGHT
+        [RED] =             {{RED_YELLOW, 0, 0, 2},        {RED_YELLOW, 0, 0, 2},        START_BLINK,                   START_NIGHT},
+        [RED_YELLOW] =      {{GREEN, 0, 0, 15},            PEDESTRIAN_GREEN,             START_BLINK,                   START_NIGHT},
+        [GREEN] =           {{YELLOW, 0, 0, 2},            {YELLOW, 0, 0, 2},            START_BLINK,                   START_NIGHT},
+        [YELLOW] =          {{RED, 0, 0, 10},              {RED, 0, 0, 10},              START_BLINK,                   START_NIGHT},
+        [BLINKING_YELLOW] = {{RED, 0, 0, 10},              {RED, 0, 0, 10},              {BLINKING_YELLOW, 0, 0, 1},    START_NIGHT},
+        [OFF] =             {{RED, 0, 0, 10},              {RED, 0, 0, 10},              START_BLINK,                   {OFF, TRANSITION_QUIET, 0, DURATION_UNTIL_MODE_CHANGE}},
+    },
+    .serves = {
+        [GREEN] = (1 << 0) | (1 << 2),
+        [RED] = 1 << 1,
+        [BLINKING_YELLOW] = (1 << 0) | (1 << 1) | (1 << 2),
+        [OFF] = (1 << 0) | (1 << 1) | (1 << 2),
+    },
+    .pedestrian = {
+        .max_wait = 0,
+        .min_green = {[RED] = 5},
+        .walk = 1 << GREEN,
+    },
+};
+
+static const char *event_names[NUM_PHASE_EVENTS] = {"timer", "pedestrian", "blink", "night"};
+
+// State names as written in the plan file, only needed while loading
+typedef struct
+{
+    char ids[MAX_PLAN_STATES][PLAN_NAME_LENGTH];
+    bool defined[MAX_PLAN_STATES][NUM_PHASE_EVENTS];
+} PlanParser;
+
+// Copy a state name, false if it does not fit
+static bool copy_name(char *name, const char *text)
+{
+    size_t length = strlen(text);
+    if (length >= PLAN_NAME_LENGTH)
+    {
+        return false;
+    }
+
+    memcpy(name, text, length + 1);
+    return true;
+}
+
+static int find_state(const PhasePlan *plan, const PlanParser *parser, const char *id)
+{
+    for (int i = 0; i < plan->num_states; i++)
+    {
+        if (strcmp(parser->ids[i], id) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int find_event(const char *name)
+{
+    for (int i = 0; i < NUM_PHASE_EVENTS; i++)
+    {
+        if (strcmp(event_names[i], name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Index of a message, added to the plan if it is new. -1 if the plan is full.
+static int add_message(PhasePlan *plan, const char *text)
+{
+    if (text[0] == '\0')
+    {
+        return 0;
+    }
+
+    for (int i = 1; i < plan->num_messages; i++)
+    {
+        if (strcmp(plan->messages[i], text) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (plan->num_messages == MAX_PLAN_MESSAGES)
+    {
+        return -1;
+    }
+
+    snprintf(plan->messages[plan->num_messages], PLAN_TEXT_LENGTH, "%s", text);
+    return plan->num_messages++;
+}
+
+// Split off the quoted text of a line ("..." up to the last quote) into 'text'
+// and cut the line before it
+static void take_quoted(char *line, char *text, size_t size)
+{
+    text[0] = '\0';
+
+    char *open = strchr(line, '"');
+    char *close = (open != NULL) ? strrchr(line, '"') : NULL;
+    if (open == NULL || close == open)
+    {
+        return;
+    }
+
+    *close = '\0';
+    snprintf(text, size, "%s", open + 1);
+    *open = '\0';
+}
+
+// Parse one 'transition FROM EVENT TO SECONDS|mode [quiet] [serve]' line
+static int parse_transition(PhasePlan *plan, PlanParser *parser, char **save, const char *message)
+{
+    const char *from = strtok_r(NULL, " \t\r\n", save);
+    const char *event_name = strtok_r(NULL, " \t\r\n", save);
+    const char *to = strtok_r(NULL, " \t\r\n", save);
+    const char *length = strtok_r(NULL, " \t\r\n", save);
+    if (from == NULL || event_name == NULL || to == NULL || length == NULL)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    Transition transition = {0};
+    int next = find_state(plan, parser, to);
+    int event = find_event(event_name);
+    int message_index = add_message(plan, message);
+    if (next < 0 || event < 0 || message_index < 0)
+    {
+        return INVALID_ARGUMENT;
+    }
+    transition.next = (uint8_t)next;
+    transition.message = (uint8_t)message_index;
+
+    if (strcmp(length, "mode") == 0)
+    {
+        transition.duration = DURATION_UNTIL_MODE_CHANGE;
+    }
+    else
+    {
+        int duration;
+        if (!parse_int(length, 1, MAX_PLAN_SECONDS, &duration))
+        {
+            return INVALID_ARGUMENT;
+        }
+        transition.duration = duration;
+    }
+
+    const char *flag;
+    while ((flag = strtok_r(NULL, " \t\r\n", save)) != NULL)
+    {
+        if (strcmp(flag, "quiet") == 0)
+        {
+            transition.flags |= TRANSITION_QUIET;
+        }
+        else if (strcmp(flag, "serve") == 0)
+        {
+            transition.flags |= TRANSITION_SERVE;
+        }
+        else
+        {
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    // '*' stands for every state declared so far
+    int first = 0;
+    int last = plan->num_states - 1;
+    if (strcmp(from, "*") != 0)
+    {
+        first = last = find_state(plan, parser, from);
+        if (first < 0)
+        {
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    for (int state = first; state <= last; state++)
+    {
+        plan->table[state][event] = transition;
+        parser->defined[state][event] = true;
+    }
+
+    return SUCCESS;
+}
+
+// Parse one 'serves ID APPROACH...' line
+static int parse_serves(PhasePlan *plan, PlanParser *parser, char **save)
+{
+    const char *id = strtok_r(NULL, " \t\r\n", save);
+    int state = (id != NULL) ? find_state(plan, parser, id) : -1;
+    if (state < 0)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    const char *approach;
+    while ((approach = strtok_r(NULL, " \t\r\n", save)) != NULL)
+    {
+        int a;
+        if (!parse_int(approach, 0, MAX_APPROACHES - 1, &a))
+        {
+            return INVALID_ARGUMENT;
+        }
+        plan->serves[state] |= (uint8_t)(1 << a);
+    }
+
+    return SUCCESS;
+}
+
+// Parse one 'actuate ID MAX_SECONDS GAP_SECONDS' line
+static int parse_actuate(PhasePlan *plan, PlanParser *parser, char **save)
+{
+    const char *id = strtok_r(NULL, " \t\r\n", save);
+    const char *max_green = strtok_r(NULL, " \t\r\n", save);
+    const char *gap = strtok_r(NULL, " \t\r\n", save);
+    int state = (id != NULL) ? find_state(plan, parser, id) : -1;
+    if (state < 0 || max_green == NULL || gap == NULL)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    int max_seconds;
+    int gap_seconds;
+    if (!parse_int(max_green, 1, MAX_PLAN_SECONDS, &max_seconds) || !parse_int(gap, 1, MAX_PLAN_SECONDS, &gap_seconds))
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    plan->actuation[state].max_green = max_seconds;
+    plan->actuation[state].gap = gap_seconds;
+    return SUCCESS;
+}
+
+// Parse one 'walk ID...' line
+static int parse_walk(PhasePlan *plan, PlanParser *parser, char **save)
+{
+    const char *id;
+    int count = 0;
+    while ((id = strtok_r(NULL, " \t\r\n", save)) != NULL)
+    {
+        int state = find_state(plan, parser, id);
+        if (state < 0)
+        {
+            return INVALID_ARGUMENT;
+        }
+        plan->pedestrian.walk |= (uint16_t)(1 << state);
+        count++;
+    }
+
+    return (count > 0) ? SUCCESS : INVALID_ARGUMENT;
+}
+
+// Parse one 'preempt ID MIN_SECONDS' line
+static int parse_preempt(PhasePlan *plan, PlanParser *parser, char **save)
+{
+    const char *id = strtok_r(NULL, " \t\r\n", save);
+    const char *min_green = strtok_r(NULL, " \t\r\n", save);
+    int state = (id != NULL) ? find_state(plan, parser, id) : -1;
+    if (state < 0 || min_green == NULL)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    int seconds;
+    if (!parse_int(min_green, 1, MAX_PLAN_SECONDS, &seconds))
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    plan->pedestrian.min_green[state] = seconds;
+    return SUCCESS;
+}
+
+/*
+ * Function: load_phase_plan
+ * -----------------------------
+ * Reads a phase plan from a text file. Each line is one of
+ *
+ *   state ID ["output"]
+ *   initial ID SECONDS
+ *   transition FROM EVENT TO SECONDS|mode [quiet] [serve] ["message"]
+ *   serves ID APPROACH...
+ *   actuate ID MAX_SECONDS GAP_SECONDS
+ *   walk ID...
+ *   preempt ID MIN_SECONDS
+ *   max_wait SECONDS
+ *
+ * FROM may be '*' for all states declared so far, and a later line overrides an
+ * earlier one, so general rules come first. 'serves' lists the approaches
+ * that may go in a state, and 'actuate' makes its length depend on the
+ * detectors of those approaches. 'walk' lists the states in which pedestrians
+ * may start crossing, 'preempt' lets a pedestrian request cut a state short
+ * after its minimum, and 'max_wait' is how long a request waits before it
+ * does (see PedestrianPolicy). Empty lines and lines starting with '#' are
+ * ignored. Every state needs a transition for every event.
+ *
+ * Returns:
+ * - SUCCESS if the plan is complete.
+ * - INVALID_ARGUMENT if the file cannot be read or a line is invalid.
+ */
+int load_phase_plan(const char *filename, PhasePlan *plan)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror("Error opening phase plan");
+        return INVALID_ARGUMENT;
+    }
+
+    memset(plan, 0, sizeof(*plan));
+    plan->initial = -1;
+    plan->num_messages = 1;
+
+    PlanParser parser;
+    memset(&parser, 0, sizeof(parser));
+
+    char line[256];
+    int line_number = 0;
+    int result = SUCCESS;
+    while (result == SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+
+        char text[PLAN_TEXT_LENGTH];
+        take_quoted(line, text, sizeof(text));
+
+        char *save;
+        const char *keyword = strtok_r(line, " \t\r\n", &save);
+        if (keyword == NULL || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        if (strcmp(keyword, "state") == 0)
+        {
+            const char *id = strtok_r(NULL, " \t\r\n", &save);
+            if (id == NULL || plan->num_states == MAX_PLAN_STATES || find_state(plan, &parser, id) >= 0 ||
+                !copy_name(parser.ids[plan->num_states], id) ||
+                !copy_name(plan->state_names[plan->num_states], (text[0] != '\0') ? text : id))
+            {
+                result = INVALID_ARGUMENT;
+                break;
+            }
+            plan->num_states++;
+        }
+        else if (strcmp(keyword, "initial") == 0)
+        {
+            const char *id = strtok_r(NULL, " \t\r\n", &save);
+            const char *length = strtok_r(NULL, " \t\r\n", &save);
+            plan->initial = (id != NULL) ? find_state(plan, &parser, id) : -1;
+            if (plan->initial < 0 || !parse_int(length, 1, MAX_PLAN_SECONDS, &plan->initial_duration))
+            {
+                result = INVALID_ARGUMENT;
+            }
+        }
+        else if (strcmp(keyword, "transition") == 0)
+        {
+            result = parse_transition(plan, &parser, &save, text);
+        }
+        else if (strcmp(keyword, "serves") == 0)
+        {
+            result = parse_serves(plan, &parser, &save);
+        }
+        else if (strcmp(keyword, "actuate") == 0)
+        {
+            result = parse_actuate(plan, &parser, &save);
+        }
+        else if (strcmp(keyword, "walk") == 0)
+        {
+            result = parse_walk(plan, &parser, &save);
+        }
+        else if (strcmp(keyword, "preempt") == 0)
+        {
+            result = parse_preempt(plan, &parser, &save);
+        }
+        else if (strcmp(keyword, "max_wait") == 0)
+        {
+            const char *seconds = strtok_r(NULL, " \t\r\n", &save);
+            int max_wait;
+            if (parse_int(seconds, 0, MAX_PLAN_SECONDS, &max_wait))
+            {
+                plan->pedestrian.max_wait = max_wait;
+            }
+            else
+            {
+                result = INVALID_ARGUMENT;
+            }
+        }
+        else
+        {
+            result = INVALID_ARGUMENT;
+        }
+    }
+
+    fclose(file);
+
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Invalid line %d in phase plan %s\n", line_number, filename);
+        return result;
+    }
+
+    if (plan->initial < 0)
+    {
+        fprintf(stderr, "Error: Phase plan %s has no initial state\n", filename);
+        return INVALID_ARGUMENT;
+    }
+
+    for (int state = 0; state < plan->num_states; state++)
+    {
+        if (plan->actuation[state].max_green > 0 && plan->serves[state] == 0)
+        {
+            fprintf(stderr, "Error: Phase plan %s actuates %s, which serves no approach\n", filename, parser.ids[state]);
+            return INVALID_ARGUMENT;
+        }
+        if (plan->pedestrian.min_green[state] > 0 && plan->serves[state] == 0)
+        {
+            fprintf(stderr, "Error: Phase plan %s preempts %s, which is no green\n", filename, parser.ids[state]);
+            return INVALID_ARGUMENT;
+        }
+        for (int event = 0; event < NUM_PHASE_EVENTS; event++)
+        {
+            if (!parser.defined[state][event])
+            {
+                fprintf(stderr, "Error: Phase plan %s has no transition from %s on %s\n",
+                        filename, parser.ids[state], event_names[event]);
+                return INVALID_ARGUMENT;
+            }
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "schedule.h"
+#include "error_codes.h"
+
+#define SCHEDULE_HORIZON_DAYS 366 // How far ahead schedule_mode() looks for a change
+
+const Schedule default_schedule = {
+    .num_profiles = 1,
+    .profiles = {
+        {
+            .name = "daily",
+            .num_entries = 5,
+            .entries = {
+                {0, MODE_NIGHT},
+                {NIGHT_END * 60 - TRANSITION_DURATION / 60, MODE_BLINK},
+                {NIGHT_END * 60, MODE_DAY},
+                {NIGHT_START * 60 - TRANSITION_DURATION / 60, MODE_BLINK},
+                {NIGHT_START * 60, MODE_NIGHT},
+            },
+        },
+    },
+    .weekday_profile = {0, 0, 0, 0, 0, 0, 0},
+    .num_holidays = 0,
+};
+
+static const char *mode_names[] = {"day", "blink", "night"};
+static const char *weekday_names[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+const char *day_mode_name(DayMode mode)
+{
+    return mode_names[mode];
+}
+
+// The profile that runs on a (broken-down) local date
+static const DayProfile *profile_for(const Schedule *schedule, const struct tm *day)
+{
+    int date = (day->tm_year + 1900) * 10000 + (day->tm_mon + 1) * 100 + day->tm_mday;
+    for (int i = 0; i < schedule->num_holidays; i++)
+    {
+        if (schedule->holidays[i].date == date)
+        {
+            return &schedule->profiles[schedule->holidays[i].profile];
+        }
+    }
+
+    return &schedule->profiles[schedule->weekday_profile[day->tm_wday]];
+}
+
+// The local date 'offset' days after 'day', normalized by mktime() (which
+// also fills in the weekday)
+static void add_days(const struct tm *day, int offset, struct tm *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->tm_year = day->tm_year;
+    result->tm_mon = day->tm_mon;
+    result->tm_mday = day->tm_mday + offset;
+    result->tm_hour = 12; // Midday is never skipped or repeated by a DST change
+    result->tm_isdst = -1;
+    mktime(result);
+}
+
+// Instant of a local time of day on a date. mktime() applies the UTC offset
+// in force at that moment, so boundaries stay at the same wall-clock time
+// across DST changes.
+static SimTime local_instant(const struct tm *day, int minute)
+{
+    struct tm local_time;
+    memset(&local_time, 0, sizeof(local_time));
+    local_time.tm_year = day->tm_year;
+    local_time.tm_mon = day->tm_mon;
+    local_time.tm_mday = day->tm_mday;
+    local_time.tm_hour = minute / 60;
+    local_time.tm_min = minute % 60;
+    local_time.tm_isdst = -1;
+
+    return (SimTime)mktime(&local_time) * NS_PER_SECOND;
+}
+
+/*
+ * Function: schedule_mode
+ * -----------------------------
+ * Looks up the mode in force at 'time' and the instant at which it next
+ * changes: the next profile entry with a different mode, on this day or one
+ * of the following days (weekday profiles and holidays included). Entries
+ * that keep the mode, such as the night continuing past midnight, are not
+ * boundaries.
+ *
+ * This is the only place that converts to local time. The controller calls
+ * it once per boundary and arms a timer for 'next_change', so the mode
+ * changes on the exact second and no time is looked up in between.
+ *
+ * Returns the mode; 'next_change' is NO_MODE_CHANGE if the mode stays the same
+ * for a year.
+ */
+DayMode schedule_mode(const Schedule *schedule, SimTime time, SimTime *next_change)
+{
+    struct tm now;
+    clock_local_time(time, &now);
+
+    const DayProfile *profile = profile_for(schedule, &now);
+    int minute = now.tm_hour * 60 + now.tm_min;
+    int index = 0;
+    while (index + 1 < profile->num_entries && profile->entries[index + 1].minute <= minute)
+    {
+        index++;
+    }
+    DayMode mode = profile->entries[index].mode;
+
+    struct tm day = now;
+    for (int offset = 0; offset <= SCHEDULE_HORIZON_DAYS; offset++)
+    {
+        if (offset > 0)
+        {
+            add_days(&now, offset, &day);
+            profile = profile_for(schedule, &day);
+            index = -1;
+        }
+
+        for (int i = index + 1; i < profile->num_entries; i++)
+        {
+            if (profile->entries[i].mode == mode)
+            {
+                continue;
+            }
+
+            SimTime change = local_instant(&day, profile->entries[i].minute);
+            if (change > time) // Not the case for a time repeated when the clocks go back
+            {
+                *next_change = change;
+                return mode;
+            }
+        }
+    }
+
+    *next_change = NO_MODE_CHANGE;
+    return mode;
+}
+
+static int find_profile(const Schedule *schedule, const char *name)
+{
+    for (int i = 0; i < schedule->num_profiles; i++)
+    {
+        if (strcmp(schedule->profiles[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Parse 'profile NAME HH:MM MODE [HH:MM MODE ...]'
+static int parse_profile(Schedule *schedule, char **save)
+{
+    const char *name = strtok_r(NULL, " \t\r\n", save);
+    if (name == NULL || strlen(name) >= PROFILE_NAME_LENGTH || find_profile(schedule, name) >= 0 ||
+        schedule->num_profiles == MAX_SCHEDULE_PROFILES)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    DayProfile *profile = &schedule->profiles[schedule->num_profiles];
+    memset(profile, 0, sizeof(*profile));
+    strcpy(profile->name, name);
+
+    const char *start;
+    while ((start = strtok_r(NULL, " \t\r\n", save)) != NULL)
+    {
+        const char *mode_name = strtok_r(NULL, " \t\r\n", save);
+        int hours, minutes;
+        if (mode_name == NULL || profile->num_entries == MAX_PROFILE_ENTRIES ||
+            sscanf(start, "%d:%d", &hours, &minutes) != 2 || hours < 0 || hours > 23 || minutes < 0 || minutes > 59)
+        {
+            return INVALID_ARGUMENT;
+        }
+
+        ScheduleEntry *entry = &profile->entries[profile->num_entries];
+        entry->minute = hours * 60 + minutes;
+        entry->mode = MODE_DAY;
+        while ((int)entry->mode <= MODE_NIGHT && strcmp(mode_names[entry->mode], mode_name) != 0)
+        {
+            entry->mode++;
+        }
+
+        // Entries must be in order, starting at midnight
+        bool in_order = (profile->num_entries == 0) ? entry->minute == 0
+                                                    : entry->minute > profile->entries[profile->num_entries - 1].minute;
+        if ((int)entry->mode > MODE_NIGHT || !in_order)
+        {
+            return INVALID_ARGUMENT;
+        }
+        profile->num_entries++;
+    }
+
+    if (profile->num_entries == 0)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    schedule->num_profiles++;
+    return SUCCESS;
+}
+
+// Parse 'days DAY [DAY ...] PROFILE', where a day is sun..sat or 'all'
+static int parse_days(Schedule *schedule, char **save, bool assigned[7])
+{
+    const char *words[9];
+    int count = 0;
+    const char *word;
+    while (count < 9 && (word = strtok_r(NULL, " \t\r\n", save)) != NULL)
+    {
+        words[count++] = word;
+    }
+
+    int profile = (count >= 2) ? find_profile(schedule, words[count - 1]) : -1;
+    if (profile < 0)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    for (int i = 0; i < count - 1; i++)
+    {
+        int weekday = 0;
+        while (weekday < 7 && strcmp(weekday_names[weekday], words[i]) != 0)
+        {
+            weekday++;
+        }
+
+        for (int day = 0; day < 7; day++)
+        {
+            if (day == weekday || strcmp(words[i], "all") == 0)
+            {
+                schedule->weekday_profile[day] = profile;
+                assigned[day] = true;
+            }
+        }
+
+        if (weekday == 7 && strcmp(words[i], "all") != 0)
+        {
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    return SUCCESS;
+}
+
+// Parse 'holiday YYYY-MM-DD PROFILE'
+static int parse_holiday(Schedule *schedule, char **save)
+{
+    const char *date = strtok_r(NULL, " \t\r\n", save);
+    const char *name = strtok_r(NULL, " \t\r\n", save);
+    int year, month, day;
+    int profile = (name != NULL) ? find_profile(schedule, name) : -1;
+    if (date == NULL || profile < 0 || schedule->num_holidays == MAX_HOLIDAYS ||
+        sscanf(date, "%d-%d-%d", &year, &month, &day) != 3)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    schedule->holidays[schedule->num_holidays].date = year * 10000 + month * 100 + day;
+    schedule->holidays[schedule->num_holidays].profile = profile;
+    schedule->num_holidays++;
+    return SUCCESS;
+}
+
+/*
+ * Function: load_schedule
+ * -----------------------------
+ * Reads a schedule from a text file. Each line is one of
+ *
+ *   profile NAME HH:MM MODE [HH:MM MODE ...]
+ *   days DAY [DAY ...] PROFILE
+ *   holiday YYYY-MM-DD PROFILE
+ *
+ * A mode is day, blink or night, and a profile's entries start at 00:00 and
+ * are in order. A day is sun, mon, ..., sat or 'all', and every weekday needs
+ * a profile. Empty lines and lines starting with '#' are ignored.
+ *
+ * Returns:
+ * - SUCCESS if the schedule is complete.
+ * - INVALID_ARGUMENT if the file cannot be read or is invalid.
+ */
+int load_schedule(const char *filename, Schedule *schedule)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror("Error opening schedule");
+        return INVALID_ARGUMENT;
+    }
+
+    memset(schedule, 0, sizeof(*schedule));
+    bool assigned[7] = {false};
+
+    char line[512];
+    int line_number = 0;
+    int result = SUCCESS;
+    while (result == SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+
+        char *save;
+        const char *keyword = strtok_r(line, " \t\r\n", &save);
+        if (keyword == NULL || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        if (strcmp(keyword, "profile") == 0)
+        {
+            result = parse_profile(schedule, &save);
+        }
+        else if (strcmp(keyword, "days") == 0)
+        {
+            result = parse_days(schedule, &save, assigned);
+        }
+        else if (strcmp(keyword, "holiday") == 0)
+        {
+            result = parse_holiday(schedule, &save);
+        }
+        else
+        {
+            result = INVALID_ARGUMENT;
+        }
+    }
+
+    fclose(file);
+
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "Error: Invalid line %d in schedule %s\n", line_number, filename);
+        return result;
+    }
+
+    for (int day = 0; day < 7; day++)
+    {
+        if (!assigned[day])
+        {
+            fprintf(stderr, "Error: Schedule %s has no profile for %s\n", filename, weekday_names[day]);
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "traffic_light.h"
+#include "controller.h"
+#include "input.h"
+#include "clock.h"
+#include "error_codes.h"
+#include "parse.h"
+
+#define DEFAULT_START "2024-03-04 00:00:00" // A Monday, so that every run sees the same days
+#define DEFAULT_MAIN_DEMAND 600.0           // Vehicles per hour facing the light (approach 0)
+#define DEFAULT_CROSS_DEMAND 150.0          // Vehicles per hour on the crossing street (approach 1)
+#define DEFAULT_OPPOSITE_DEMAND 0.0         // Vehicles per hour on the main street the other way (approach 2)
+#define DEFAULT_PEDESTRIAN_DEMAND 30.0      // Pedestrians per hour at the button
+#define MAX_DEMAND 1e6                      // Vehicles or pedestrians per hour
+
+static void print_usage(void)
+{
+    fprintf(stderr, "Usage: traffic_sim [--intersections N] [--threads N] [--start \"YYYY-MM-DD HH:MM:SS\"]\n"
+                    "                   [--days N | --duration SECONDS] [--vehicles PER_HOUR] [--cross PER_HOUR]\n"
+                    "                   [--opposite PER_HOUR] [--pedestrians PER_HOUR] [--seed N] [--detectors FILE]\n"
+                    "                   [--corridor FILE [--uncoordinated]] [--plan FILE] [--schedule FILE]\n"
+                    "                   [--max-wait SECONDS] [--min-green SECONDS] [--trace ID] [--log FILE]\n"
+                    "  --intersections N      Simulated intersections (default 1)\n"
+                    "  --threads N            Worker threads, each owning a shard of the intersections\n"
+                    "  --start TIME           Simulated start time (default " DEFAULT_START ")\n"
+                    "  --days N               Simulated days (default 1)\n"
+                    "  --duration SECONDS     Simulated time in seconds instead of days\n"
+                    "  --vehicles PER_HOUR    Poisson arrivals facing the light, approach 0 (default 600)\n"
+                    "  --cross PER_HOUR       Poisson arrivals on the crossing street, approach 1 (default 150)\n"
+                    "  --opposite PER_HOUR    Poisson arrivals on the main street the other way, approach 2 (default 0)\n"
+                    "  --pedestrians PER_HOUR Poisson arrivals at the pedestrian button (default 30)\n"
+                    "  --seed N               Seed of the arrivals (default 1)\n"
+                    "  --detectors FILE       Replay recorded vehicles instead of the Poisson vehicles\n"
+                    "  --corridor FILE        Coordinate the first intersections along a main street; its vehicles\n"
+                    "                         enter at the two ends and drive from light to light\n"
+                    "  --uncoordinated        The same corridor traffic with the lights running free from random start\n"
+                    "                         phases (from --seed), for comparison\n"
+                    "  --plan FILE            Phase plan to run instead of the built-in one\n"
+                    "  --schedule FILE        Day/blink/night times per weekday and holiday\n"
+                    "  --max-wait SECONDS     How long a pedestrian request waits before it cuts a phase short\n"
+                    "  --min-green SECONDS    Shortest a phase that a request may cut short runs (see the plan)\n"
+                    "  --trace ID             Intersection whose transitions are printed (default -1, none)\n"
+                    "  --log FILE             Binary trace of every intersection\n");
+}
+
+/*
+ * Function: main
+ * -----------------------------
+ * Discrete-event simulation of the controller. Vehicles and pedestrians
+ * arrive at random (Poisson) or from a detector replay, the controller runs
+ * unchanged on the virtual clock, and a queue model at each approach measures
+ * what the drivers and pedestrians get out of it. Along a corridor the
+ * main-street vehicles drive on from light to light at the design speed.
+ * The summary reports queue lengths, vehicle waits, stops, green time,
+ * pedestrian service latency and how many events per second the simulation
+ * itself handles; --max-wait and --min-green change the pedestrian policy of
+ * the plan to compare its cost.
+ */
+int main(int argc, char *argv[])
+{
+    SimTime start;
+    clock_parse(DEFAULT_START, &start);
+    double duration = 24.0 * 3600.0;
+    int num_lights = 1;
+    int num_threads = 1;
+    int trace_id = -1;
+    const char *log_file = NULL;
+    const char *replay_file = NULL;
+    const char *corridor_file = NULL;
+    bool coordinated = true;
+    int max_wait = -1;  // Pedestrian policy of the plan, unless given
+    int min_green = -1;
+    static PhasePlan loaded_plan;
+    const PhasePlan *plan = &default_phase_plan;
+    static Schedule loaded_schedule;
+    const Schedule *schedule = &default_schedule;
+    TrafficDemand demand = {
+        .vehicles_per_hour = {DEFAULT_MAIN_DEMAND, DEFAULT_CROSS_DEMAND, DEFAULT_OPPOSITE_DEMAND},
+        .pedestrians_per_hour = DEFAULT_PEDESTRIAN_DEMAND,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        int result = SUCCESS;
+
+        if (strcmp(argv[i], "--intersections") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], 1, INT_MAX, &num_lights) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], 1, MAX_CONTROLLER_THREADS, &num_threads) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--start") == 0 && has_value)
+        {
+            result = clock_parse(argv[++i], &start);
+        }
+        else if (strcmp(argv[i], "--days") == 0 && has_value)
+        {
+            double days = 0.0;
+            result = (parse_double(argv[++i], 0.0, MAX_RUN_SECONDS / (24.0 * 3600.0), &days) && days > 0.0)
+                         ? SUCCESS : INVALID_ARGUMENT;
+            duration = days * 24.0 * 3600.0;
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && has_value)
+        {
+            bool valid = parse_double(argv[++i], 0.0, MAX_RUN_SECONDS, &duration) && duration > 0.0;
+            result = valid ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--vehicles") == 0 && has_value)
+        {
+            result = parse_double(argv[++i], 0.0, MAX_DEMAND, &demand.vehicles_per_hour[0]) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--cross") == 0 && has_value)
+        {
+            result = parse_double(argv[++i], 0.0, MAX_DEMAND, &demand.vehicles_per_hour[1]) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--opposite") == 0 && has_value)
+        {
+            result = parse_double(argv[++i], 0.0, MAX_DEMAND, &demand.vehicles_per_hour[2]) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--pedestrians") == 0 && has_value)
+        {
+            result = parse_double(argv[++i], 0.0, MAX_DEMAND, &demand.pedestrians_per_hour) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && has_value)
+        {
+            char *end;
+            demand.seed = strtoull(argv[++i], &end, 10);
+            result = (end != argv[i] && *end == '\0') ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--detectors") == 0 && has_value)
+        {
+            replay_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--corridor") == 0 && has_value)
+        {
+            corridor_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--uncoordinated") == 0)
+        {
+            coordinated = false;
+        }
+        else if (strcmp(argv[i], "--max-wait") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], 0, 24 * 3600, &max_wait) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--min-green") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], 1, 24 * 3600, &min_green) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && has_value)
+        {
+            result = parse_int(argv[++i], -1, INT_MAX, &trace_id) ? SUCCESS : INVALID_ARGUMENT;
+        }
+        else if (strcmp(argv[i], "--log") == 0 && has_value)
+        {
+            log_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--plan") == 0 && has_value)
+        {
+            result = load_phase_plan(argv[++i], &loaded_plan);
+            plan = &loaded_plan;
+        }
+        else if (strcmp(argv[i], "--schedule") == 0 && has_value)
+        {
+            result = load_schedule(argv[++i], &loaded_schedule);
+            schedule = &loaded_schedule;
+        }
+        else
+        {
+            result = INVALID_ARGUMENT;
+        }
+
+        if (result != SUCCESS)
+        {
+            print_usage();
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    // Policies are compared on the same plan: change a copy of it
+    if (max_wait >= 0 || min_green > 0)
+    {
+        if (plan != &loaded_plan)
+        {
+            loaded_plan = *plan;
+            plan = &loaded_plan;
+        }
+        PedestrianPolicy *policy = &loaded_plan.pedestrian;
+        for (int s = 0; s < loaded_plan.num_states && min_green > 0; s++)
+        {
+            if (policy->min_green[s] > 0)
+            {
+                policy->min_green[s] = min_green;
+            }
+        }
+        if (max_wait >= 0)
+        {
+            policy->max_wait = max_wait;
+        }
+    }
+
+    Clock clock;
+    ErrorCode error_code = clock_init(&clock, CLOCK_MODE_VIRTUAL, 1.0, start);
+    if (error_code != SUCCESS)
+    {
+        fprintf(stderr, "Error: Failed to initialize the simulation clock (Error Code: %d)\n", error_code);
+        return error_code;
+    }
+
+    // The corridor's cycle comes from the plan; offsets missing from the file
+    // are optimized for the design speed
+    static Corridor corridor;
+    if (corridor_file != NULL)
+    {
+        error_code = load_corridor(corridor_file, &corridor);
+        if (error_code == SUCCESS)
+        {
+            error_code = corridor_timing(&corridor, plan);
+        }
+        if (error_code != SUCCESS)
+        {
+            return error_code;
+        }
+        if (!corridor.has_offsets)
+        {
+            optimize_offsets(&corridor);
+        }
+        corridor.coordinated = coordinated;
+        if (!coordinated)
+        {
+            randomize_start_phases(&corridor, demand.seed);
+        }
+        if (num_lights < corridor.num_intersections)
+        {
+            num_lights = corridor.num_intersections;
+        }
+        print_corridor(&corridor);
+    }
+
+    if (trace_id < -1 || trace_id >= num_lights)
+    {
+        fprintf(stderr, "Error: No intersection %d to trace (0 to %d, or -1 for none)\n", trace_id, num_lights - 1);
+        return INVALID_ARGUMENT;
+    }
+
+    // Recorded vehicles take the place of the random ones; pedestrians stay random
+    InputEvent *replay = NULL;
+    int num_replay = 0;
+    if (replay_file != NULL)
+    {
+        error_code = load_detector_replay(replay_file, clock.start, &replay, &num_replay);
+        if (error_code != SUCCESS)
+        {
+            return error_code;
+        }
+        for (int a = 0; a < MAX_APPROACHES; a++)
+        {
+            demand.vehicles_per_hour[a] = 0.0;
+        }
+    }
+
+    GridConfig config = {
+        .clock = &clock,
+        .plan = plan,
+        .schedule = schedule,
+        .num_lights = num_lights,
+        .num_threads = num_threads,
+        .end = clock.start + (SimTime)(duration * NS_PER_SECOND),
+        .trace_id = trace_id,
+        .log_file = log_file,
+        .replay = replay,
+        .num_replay = num_replay,
+        .demand = &demand,
+        .corridor = (corridor_file != NULL) ? &corridor : NULL,
+    };
+    error_code = run_grid(&config);
+
+    free(replay);
+
+    if (error_code != SUCCESS)
+    {
+        fprintf(stderr, "Error: Simulation failed (Error Code: %d)\n", error_code);
+        return error_code;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "error_codes.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+// Continue an FNV-1a hash over more bytes
+static uint32_t checksum_update(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint32_t snapshot_checksum(const void *data, size_t size)
+{
+    return checksum_update(FNV_OFFSET_BASIS, data, size);
+}
+
+// Everything in the plan that decides what a saved state and deadline mean:
+// the states, every transition with its duration, the approaches served and
+// the actuated and pedestrian timing. Plans that only differ in their timing
+// (e.g. default.plan and actuated.plan) get different checksums. The fields
+// are hashed one by one, so the padding inside the structs does not count.
+static uint32_t plan_checksum(const PhasePlan *plan)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    hash = checksum_update(hash, &plan->num_states, sizeof(plan->num_states));
+    hash = checksum_update(hash, &plan->initial, sizeof(plan->initial));
+    hash = checksum_update(hash, &plan->initial_duration, sizeof(plan->initial_duration));
+    for (int s = 0; s < plan->num_states; s++)
+    {
+        hash = checksum_update(hash, plan->state_names[s], strnlen(plan->state_names[s], PLAN_NAME_LENGTH));
+        for (int e = 0; e < NUM_PHASE_EVENTS; e++)
+        {
+            const Transition *transition = &plan->table[s][e];
+            hash = checksum_update(hash, &transition->next, sizeof(transition->next));
+            hash = checksum_update(hash, &transition->flags, sizeof(transition->flags));
+            hash = checksum_update(hash, &transition->duration, sizeof(transition->duration));
+        }
+        hash = checksum_update(hash, &plan->serves[s], sizeof(plan->serves[s]));
+        hash = checksum_update(hash, &plan->actuation[s].max_green, sizeof(plan->actuation[s].max_green));
+        hash = checksum_update(hash, &plan->actuation[s].gap, sizeof(plan->actuation[s].gap));
+        hash = checksum_update(hash, &plan->pedestrian.min_green[s], sizeof(plan->pedestrian.min_green[s]));
+    }
+    hash = checksum_update(hash, &plan->pedestrian.max_wait, sizeof(plan->pedestrian.max_wait));
+    return checksum_update(hash, &plan->pedestrian.walk, sizeof(plan->pedestrian.walk));
+}
+
+// The header a state file for this plan and number of lights must have
+static void fill_header(SnapshotHeader *header, const PhasePlan *plan, int num_lights)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->record_size = sizeof(LightSnapshot);
+    header->num_lights = num_lights;
+    header->plan_checksum = plan_checksum(plan);
+    header->checksum = snapshot_checksum(header, offsetof(SnapshotHeader, checksum));
+}
+
+/*
+ * Function: snapshot_open
+ * -----------------------------
+ * Maps a state file holding one record per light. A file written by a run
+ * with the same plan and number of lights is kept, and its records can be
+ * restored. A file written for another plan, number of lights or format is
+ * not overwritten: it is moved aside to FILE.old with a warning, and a new
+ * file with empty records takes its place, as it does when there is none.
+ *
+ * Returns:
+ * - SUCCESS if the file is mapped.
+ * - INVALID_ARGUMENT if it cannot be opened, moved aside, sized or mapped.
+ */
+int snapshot_open(Snapshot *snapshot, const char *filename, const PhasePlan *plan, int num_lights)
+{
+    snapshot->fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (snapshot->fd < 0)
+    {
+        perror("Error opening state file");
+        return INVALID_ARGUMENT;
+    }
+
+    SnapshotHeader expected;
+    fill_header(&expected, plan, num_lights);
+    snapshot->size = sizeof(SnapshotHeader) + (size_t)num_lights * sizeof(LightSnapshot);
+
+    struct stat status;
+    if (fstat(snapshot->fd, &status) != 0)
+    {
+        perror("Error reading state file");
+        close(snapshot->fd);
+        return INVALID_ARGUMENT;
+    }
+
+    SnapshotHeader header;
+    snapshot->restorable = (size_t)status.st_size == snapshot->size &&
+                           pread(snapshot->fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                           memcmp(&header, &expected, sizeof(expected)) == 0;
+
+    // Written by another plan, number of lights or version: keep it for whoever wrote it
+    if (!snapshot->restorable && status.st_size > 0)
+    {
+        char aside[PATH_MAX];
+        snprintf(aside, sizeof(aside), "%s.old", filename);
+        fprintf(stderr, "Warning: State file %s is for another plan or number of lights, moved to %s\n",
+                filename, aside);
+        close(snapshot->fd);
+        if (rename(filename, aside) != 0)
+        {
+            perror("Error moving state file aside");
+            return INVALID_ARGUMENT;
+        }
+        snapshot->fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (snapshot->fd < 0)
+        {
+            perror("Error creating state file");
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    // A new file is sized once; ftruncate() zero-fills it
+    if (!snapshot->restorable && ftruncate(snapshot->fd, (off_t)snapshot->size) != 0)
+    {
+        perror("Error sizing state file");
+        close(snapshot->fd);
+        return INVALID_ARGUMENT;
+    }
+
+    void *mapping = mmap(NULL, snapshot->size, PROT_READ | PROT_WRITE, MAP_SHARED, snapshot->fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        perror("Error mapping state file");
+        close(snapshot->fd);
+        return INVALID_ARGUMENT;
+    }
+
+    snapshot->header = mapping;
+    snapshot->records = (LightSnapshot *)(snapshot->header + 1);
+    *snapshot->header = expected;
+
+    return SUCCESS;
+}
+
+// Call once the shard threads have stopped
+int snapshot_close(Snapshot *snapshot)
+{
+    int result = SUCCESS;
+    if (msync(snapshot->header, snapshot->size, MS_SYNC) != 0)
+    {
+        perror("Error writing state file");
+        result = UNKNOWN_ERROR;
+    }
+
+    munmap(snapshot->header, snapshot->size);
+    close(snapshot->fd);
+    return result;
+}
+
+/*
+ * Function: snapshot_restore
+ * -----------------------------
+ * Puts a light back into the state its record holds: phase, phase start and
+ * deadline, pending pedestrian request and operator override. The record is
+ * only used if its checksum holds, it belongs to this light, it was saved in
+ * the mode the light runs in now, with the same cycle offset, and its phase
+ * had started by now. Otherwise the light is left untouched and starts afresh.
+ *
+ * Returns:
+ * - true if the light was restored.
+ */
+bool snapshot_restore(const Snapshot *snapshot, TrafficLight *light, SimTime now, DayMode scheduled)
+{
+    if (!snapshot->restorable)
+    {
+        return false;
+    }
+
+    const LightSnapshot *record = &snapshot->records[light->id];
+    int override_mode = record->override_mode;
+    DayMode mode = (override_mode >= 0) ? (DayMode)override_mode : scheduled;
+    if (record->checksum != snapshot_checksum(record, offsetof(LightSnapshot, checksum)) ||
+        record->intersection != light->id || record->state >= light->plan->num_states || record->mode != mode ||
+        record->offset != light->offset || record->phase_start > now)
+    {
+        return false;
+    }
+
+    light->state = record->state;
+    light->phase_start = record->phase_start;
+    light->phase_deadline = record->phase_deadline;
+    light->pedestrian_request = record->pedestrian_request;
+    light->request_time = record->request_time;
+    light->override_mode = override_mode;
+    return true;
+}
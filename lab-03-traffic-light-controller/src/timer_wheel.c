@@ -0,0 +1,250 @@
+#include <stdbool.h>
+#include "timer_wheel.h"
+
+static void list_init(TimerEntry *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static inline void set_occupied(TimerWheel *wheel, int level, int slot)
+{
+    wheel->occupied[level][slot / 64] |= 1ULL << (slot % 64);
+}
+
+static inline void clear_occupied(TimerWheel *wheel, int level, int slot)
+{
+    wheel->occupied[level][slot / 64] &= ~(1ULL << (slot % 64));
+}
+
+// First non-empty slot of a level at or after 'from', -1 if none
+static int next_occupied(const TimerWheel *wheel, int level, int from)
+{
+    for (int word = from / 64; word < WHEEL_SLOTS / 64; word++)
+    {
+        uint64_t bits = wheel->occupied[level][word];
+        if (word == from / 64)
+        {
+            bits &= ~0ULL << (from % 64); // Ignore the slots before 'from'
+        }
+        if (bits != 0)
+        {
+            return word * 64 + __builtin_ctzll(bits);
+        }
+    }
+
+    return -1;
+}
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t start_tick)
+{
+    wheel->now = start_tick;
+    wheel->count = 0;
+
+    for (int level = 0; level < WHEEL_LEVELS; level++)
+    {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+        {
+            list_init(&wheel->slots[level][slot]);
+        }
+        for (int word = 0; word < WHEEL_SLOTS / 64; word++)
+        {
+            wheel->occupied[level][word] = 0;
+        }
+    }
+}
+
+// Link an entry into the slot that matches its distance from 'now'
+static void insert(TimerWheel *wheel, TimerEntry *entry)
+{
+    if ((int64_t)(entry->expires - wheel->now) < 0)
+    {
+        entry->expires = wheel->now; // Already due: fire on the next tick processed
+    }
+
+    uint64_t delta = entry->expires - wheel->now;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (1ULL << (WHEEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+
+    // Beyond the range of the top level: park it in the farthest slot, it is
+    // re-inserted when that slot is cascaded
+    uint64_t range = 1ULL << (WHEEL_BITS * WHEEL_LEVELS);
+    uint64_t expires = (delta >= range) ? wheel->now + range - 1 : entry->expires;
+
+    int slot = (int)((expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    TimerEntry *head = &wheel->slots[level][slot];
+
+    entry->level = (uint8_t)level;
+    entry->slot = (uint8_t)slot;
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+    set_occupied(wheel, level, slot);
+}
+
+static void unlink_entry(TimerWheel *wheel, TimerEntry *entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+
+    TimerEntry *head = &wheel->slots[entry->level][entry->slot];
+    if (head->next == head)
+    {
+        clear_occupied(wheel, entry->level, entry->slot);
+    }
+
+    entry->next = NULL;
+    entry->prev = NULL;
+}
+
+void timer_wheel_add(TimerWheel *wheel, TimerEntry *entry, uint64_t expires)
+{
+    entry->expires = expires;
+    insert(wheel, entry);
+    wheel->count++;
+}
+
+void timer_wheel_remove(TimerWheel *wheel, TimerEntry *entry)
+{
+    if (entry->next != NULL)
+    {
+        unlink_entry(wheel, entry);
+        wheel->count--;
+    }
+}
+
+// Move every timer of one slot down to the finer levels
+static int cascade(TimerWheel *wheel, int level)
+{
+    int slot = (int)((wheel->now >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    TimerEntry *head = &wheel->slots[level][slot];
+
+    // Detach the list first, insert() may put entries back on this level
+    TimerEntry *entry = head->next;
+    list_init(head);
+    clear_occupied(wheel, level, slot);
+
+    while (entry != head)
+    {
+        TimerEntry *next = entry->next;
+        insert(wheel, entry);
+        entry = next;
+    }
+
+    return slot;
+}
+
+void timer_wheel_advance(TimerWheel *wheel, uint64_t tick, TimerCallback callback, void *context)
+{
+    while (wheel->now <= tick)
+    {
+        int index = (int)(wheel->now & WHEEL_MASK);
+
+        // Level 0 wrapped around: refill it from the next slot of level 1,
+        // and level 1 from level 2 when that wraps too
+        if (index == 0)
+        {
+            for (int level = 1; level < WHEEL_LEVELS && cascade(wheel, level) == 0; level++)
+            {
+            }
+        }
+
+        int slot = next_occupied(wheel, 0, index);
+        uint64_t window_start = wheel->now - (uint64_t)index;
+
+        if (slot < 0)
+        {
+            // Nothing left in this turn of level 0: jump to the next cascade
+            uint64_t next_window = window_start + WHEEL_SLOTS;
+            wheel->now = (next_window > tick) ? tick + 1 : next_window;
+            continue;
+        }
+
+        uint64_t due = window_start + (uint64_t)slot;
+        if (due > tick)
+        {
+            wheel->now = tick + 1;
+            break;
+        }
+
+        // Detach the due list and move 'now' past it before running the
+        // callbacks, so a timer re-added from a callback lands in a later slot
+        TimerEntry *head = &wheel->slots[0][slot];
+        TimerEntry *entry = head->next;
+        head->prev->next = NULL;
+        list_init(head);
+        clear_occupied(wheel, 0, slot);
+        wheel->now = due + 1;
+
+        while (entry != NULL)
+        {
+            TimerEntry *next = entry->next;
+            entry->next = NULL;
+            entry->prev = NULL;
+            wheel->count--;
+            callback(entry, context);
+            entry = next;
+        }
+    }
+}
+
+// Earliest tick that needs advance(): the first timer of level 0, or the
+// cascade of the first non-empty slot of a higher level, which moves its
+// timers down to where their own ticks can be seen. The wheel is never
+// woken for a turn of level 0 that has nothing to do.
+uint64_t timer_wheel_next_tick(const TimerWheel *wheel)
+{
+    if (wheel->count == 0)
+    {
+        return UINT64_MAX;
+    }
+
+    int index = (int)(wheel->now & WHEEL_MASK);
+    uint64_t window_start = wheel->now - (uint64_t)index;
+    int slot = next_occupied(wheel, 0, index);
+    if (slot >= 0 && index != 0)
+    {
+        return window_start + (uint64_t)slot; // Higher levels hold later turns only
+    }
+
+    // Level 0 slots before 'index' belong to its next turn
+    uint64_t next = UINT64_MAX;
+    slot = (slot >= 0) ? slot : next_occupied(wheel, 0, 0);
+    if (slot >= 0)
+    {
+        next = (slot >= index) ? window_start + (uint64_t)slot : window_start + WHEEL_SLOTS + (uint64_t)slot;
+    }
+
+    for (int level = 1; level < WHEEL_LEVELS; level++)
+    {
+        int shift = WHEEL_BITS * level;
+        uint64_t current = wheel->now >> shift;
+
+        // The current slot is cascaded at the start of its turn; once that
+        // has passed, whatever it holds is a whole turn of this level away
+        bool pending = (wheel->now & ((1ULL << shift) - 1)) == 0;
+        int from = (int)((current + !pending) & WHEEL_MASK);
+        slot = next_occupied(wheel, level, from);
+        if (slot < 0)
+        {
+            slot = next_occupied(wheel, level, 0);
+        }
+        if (slot < 0)
+        {
+            continue;
+        }
+
+        uint64_t distance = (uint64_t)((slot - from) & WHEEL_MASK) + !pending;
+        uint64_t cascade_tick = (current + distance) << shift;
+        if (cascade_tick < next)
+        {
+            next = cascade_tick;
+        }
+    }
+
+    return next;
+}
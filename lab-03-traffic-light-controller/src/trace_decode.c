@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "trace_log.h"
+#include "schedule.h"
+#include "error_codes.h"
+
+#define DECODE_BATCH 4096 // Records read per fread call
+
+typedef enum
+{
+    FORMAT_TEXT,
+    FORMAT_CSV,
+} OutputFormat;
+
+static void print_usage(void)
+{
+    fprintf(stderr, "Usage: trace_decode FILE [--csv] [--intersection ID]\n"
+                    "  --csv               One line per record with a header row, for spreadsheets and scripts\n"
+                    "  --intersection ID   Only the records of one intersection\n");
+}
+
+static const char *state_name(const TraceFileHeader *header, int state)
+{
+    return (state < header->num_states) ? header->state_names[state] : "?";
+}
+
+static const char *mode_name(int mode)
+{
+    return (mode >= MODE_DAY && mode <= MODE_NIGHT) ? day_mode_name((DayMode)mode) : "";
+}
+
+// Print one record. The time is formatted to the millisecond, as the phases
+// of a grid are staggered by milliseconds.
+static void print_record(const TraceFileHeader *header, const TraceRecord *record, OutputFormat format)
+{
+    char text[32];
+    clock_format(record->time - record->time % NS_PER_SECOND, text, sizeof(text));
+    int millis = (int)(record->time % NS_PER_SECOND / 1000000);
+
+    if (format == FORMAT_CSV)
+    {
+        printf("%lld,%s.%03d,%d,%s,%s,%s,%s\n", (long long)record->time, text, millis, record->intersection,
+               state_name(header, record->old_state), state_name(header, record->new_state),
+               trace_cause_name((TraceCause)record->cause), mode_name(record->mode));
+    }
+    else if (record->cause == TRACE_CAUSE_PRESS)
+    {
+        printf("%s.%03d [%d] %s: pedestrian request\n", text, millis, record->intersection,
+               state_name(header, record->new_state));
+    }
+    else
+    {
+        printf("%s.%03d [%d] %s -> %s (%s, %s mode)\n", text, millis, record->intersection,
+               state_name(header, record->old_state), state_name(header, record->new_state),
+               trace_cause_name((TraceCause)record->cause), mode_name(record->mode));
+    }
+}
+
+/*
+ * Function: main
+ * -----------------------------
+ * Renders a binary trace written by 'traffic_light --log' as text or CSV.
+ * The records of one intersection are in time order; records of different
+ * shards are interleaved in the order they were flushed.
+ */
+int main(int argc, char *argv[])
+{
+    const char *filename = NULL;
+    OutputFormat format = FORMAT_TEXT;
+    long only = -1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+        {
+            format = FORMAT_CSV;
+        }
+        else if (strcmp(argv[i], "--intersection") == 0 && i + 1 < argc)
+        {
+            only = atol(argv[++i]);
+        }
+        else if (filename == NULL && argv[i][0] != '-')
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            print_usage();
+            return INVALID_ARGUMENT;
+        }
+    }
+
+    if (filename == NULL)
+    {
+        print_usage();
+        return INVALID_ARGUMENT;
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        perror("Error opening trace log");
+        return INVALID_ARGUMENT;
+    }
+
+    TraceFileHeader header;
+    int error_code = trace_read_header(file, &header);
+    if (error_code != SUCCESS)
+    {
+        fclose(file);
+        return error_code;
+    }
+
+    if (format == FORMAT_CSV)
+    {
+        printf("time_ns,time,intersection,from,to,cause,mode\n");
+    }
+
+    static TraceRecord records[DECODE_BATCH];
+    size_t count;
+    while ((count = fread(records, sizeof(TraceRecord), DECODE_BATCH, file)) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (only < 0 || records[i].intersection == only)
+            {
+                print_record(&header, &records[i], format);
+            }
+        }
+    }
+
+    if (ferror(file))
+    {
+        perror("Error reading trace log");
+        error_code = UNKNOWN_ERROR;
+    }
+
+    fclose(file);
+    return error_code;
+}
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "trace_log.h"
+#include "error_codes.h"
+
+#define RING_MASK (TRACE_RING_SIZE - 1)
+
+static const char *cause_names[NUM_TRACE_CAUSES] = {
+    "timer", "pedestrian", "blink", "night", "start", "schedule", "override", "press", "gap-out", "max-out",
+    "resume",
+};
+
+const char *trace_cause_name(TraceCause cause)
+{
+    return ((unsigned)cause < NUM_TRACE_CAUSES) ? cause_names[cause] : "?";
+}
+
+// The ring is full as far as the producer knew. Look at the real tail; if the
+// flusher is really behind, either wait for it (virtual clock: the trace must
+// be complete, and nothing is late) or drop the record.
+bool trace_ring_wait(TraceRing *ring, size_t head)
+{
+    while (1)
+    {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->cached_tail < TRACE_RING_SIZE)
+        {
+            return true;
+        }
+        if (!ring->lossless)
+        {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        sched_yield();
+    }
+}
+
+// Write out whatever the rings hold. Returns the number of records written.
+static long flush_rings(TraceLog *log)
+{
+    long flushed = 0;
+    for (int i = 0; i < log->num_rings; i++)
+    {
+        TraceRing *ring = &log->rings[i];
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        while (tail != head)
+        {
+            // Up to the end of the buffer, the rest on the next pass
+            size_t count = head - tail;
+            size_t until_wrap = TRACE_RING_SIZE - (tail & RING_MASK);
+            if (count > until_wrap)
+            {
+                count = until_wrap;
+            }
+
+            if (log->result == SUCCESS &&
+                fwrite(&ring->records[tail & RING_MASK], sizeof(TraceRecord), count, log->file) != count)
+            {
+                perror("Error writing trace log");
+                log->result = UNKNOWN_ERROR; // Keep emptying the rings so that no shard waits forever
+            }
+
+            tail += count;
+            flushed += (long)count;
+            atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        }
+    }
+
+    log->written += flushed;
+    return flushed;
+}
+
+// Flusher thread: empties the rings, and sleeps a little whenever they are all empty
+static void *flusher_thread(void *arg)
+{
+    TraceLog *log = arg;
+    struct timespec pause = {0, TRACE_FLUSH_INTERVAL_MS * 1000000L};
+
+    while (!atomic_load_explicit(&log->stop, memory_order_acquire))
+    {
+        if (flush_rings(log) == 0)
+        {
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    flush_rings(log); // Whatever was written before the stop
+    return NULL;
+}
+
+/*
+ * Function: trace_log_open
+ * -----------------------------
+ * Creates a binary trace file, writes its header and starts the flusher
+ * thread. Each of the 'num_rings' shard threads then writes into its own ring.
+ *
+ * Returns:
+ * - SUCCESS if the file is open and the flusher runs.
+ * - INVALID_ARGUMENT if the file cannot be created.
+ * - UNKNOWN_ERROR if memory or the thread cannot be allocated.
+ */
+int trace_log_open(TraceLog *log, const char *filename, const PhasePlan *plan, SimTime start,
+                   int num_rings, bool lossless)
+{
+    log->file = fopen(filename, "wb");
+    if (log->file == NULL)
+    {
+        perror("Error opening trace log");
+        return INVALID_ARGUMENT;
+    }
+
+    log->rings = aligned_alloc(CACHE_LINE_SIZE, (size_t)num_rings * sizeof(TraceRing));
+    if (log->rings == NULL)
+    {
+        fclose(log->file);
+        return UNKNOWN_ERROR;
+    }
+
+    log->num_rings = num_rings;
+    log->written = 0;
+    log->dropped = 0;
+    log->result = SUCCESS;
+    atomic_init(&log->stop, false);
+    for (int i = 0; i < num_rings; i++)
+    {
+        TraceRing *ring = &log->rings[i];
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->dropped, 0);
+        ring->cached_tail = 0;
+        ring->lossless = lossless;
+    }
+
+    TraceFileHeader header = {0};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.start = start;
+    header.num_states = plan->num_states;
+    memcpy(header.state_names, plan->state_names, sizeof(header.state_names));
+
+    if (fwrite(&header, sizeof(header), 1, log->file) != 1)
+    {
+        perror("Error writing trace log");
+        fclose(log->file);
+        free(log->rings);
+        return INVALID_ARGUMENT;
+    }
+
+    if (pthread_create(&log->flusher, NULL, flusher_thread, log) != 0)
+    {
+        perror("Error starting trace flusher");
+        fclose(log->file);
+        free(log->rings);
+        return UNKNOWN_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+// Call once the shard threads have stopped writing
+int trace_log_close(TraceLog *log)
+{
+    atomic_store_explicit(&log->stop, true, memory_order_release);
+    pthread_join(log->flusher, NULL);
+
+    for (int i = 0; i < log->num_rings; i++)
+    {
+        log->dropped += (long)atomic_load_explicit(&log->rings[i].dropped, memory_order_relaxed);
+    }
+
+    if (fclose(log->file) != 0 && log->result == SUCCESS)
+    {
+        perror("Error closing trace log");
+        log->result = UNKNOWN_ERROR;
+    }
+    free(log->rings);
+    log->rings = NULL;
+
+    return log->result;
+}
+
+/*
+ * Function: trace_read_header
+ * -----------------------------
+ * Reads the header of a trace file and checks that the records that follow
+ * can be read by this build.
+ *
+ * Returns:
+ * - SUCCESS with the header in 'header'.
+ * - INVALID_ARGUMENT if the file is not a trace, or from another version.
+ */
+int trace_read_header(FILE *file, TraceFileHeader *header)
+{
+    if (fread(header, sizeof(*header), 1, file) != 1 ||
+        memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        fprintf(stderr, "Error: Not a trace log\n");
+        return INVALID_ARGUMENT;
+    }
+    if (header->version != TRACE_VERSION || header->record_size != sizeof(TraceRecord) ||
+        header->num_states <= 0 || header->num_states > MAX_PLAN_STATES)
+    {
+        fprintf(stderr, "Error: Unsupported trace log version %u\n", header->version);
+        return INVALID_ARGUMENT;
+    }
+
+    for (int i = 0; i < MAX_PLAN_STATES; i++)
+    {
+        header->state_names[i][PLAN_NAME_LENGTH - 1] = '\0';
+    }
+
+    return SUCCESS;
+}
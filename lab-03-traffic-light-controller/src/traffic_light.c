@@ -1,190 +1,398 @@
 #include <stdio.h>
-#include <unistd.h> // For sleep function
+#include <stdarg.h>
 #include <stdbool.h>
-#include <sys/select.h> // For non-blocking input check
-#include <time.h>       // For checking the time
 #include "traffic_light.h"
 #include "error_codes.h"
 
-static TrafficLightState current_state = RED; // Current state of the traffic light
-static bool pedestrian_request = false;       // Pedestrian light status (off by default)
-
-int init_traffic_light(void)
+int init_traffic_light(TrafficLight *light, int id, const PhasePlan *plan, const Clock *clock, TraceMode trace)
 {
-    current_state = RED;        // Initialize to RED state
-    pedestrian_request = false; // No pedestrian request initially
+    if (light == NULL || plan == NULL || clock == NULL)
+    {
+        return INVALID_ARGUMENT;
+    }
+
+    light->timer.next = NULL; // Not in a timing wheel yet
+    light->timer.prev = NULL;
+    light->id = id;
+    light->state = plan->initial;      // RED in the built-in plan
+    light->plan = plan;
+    light->pedestrian_request = false; // No pedestrian request initially
+    light->request_time = 0;
+    light->day_start = 0;
+    atomic_init(&light->button_latched, false);
+    light->override_mode = -1;
+    light->calls = 0;
+    for (int a = 0; a < MAX_APPROACHES; a++)
+    {
+        light->last_detection[a] = INT64_MIN / 2; // Long ago, without overflow when adding the gap
+    }
+    light->trace = trace;
+    light->log = NULL;
+    light->clock = clock;
+    light->phase_start = 0;
+    light->phase_deadline = 0;
+    light->coordination = NULL;
+    light->offset = 0;
+    light->start_phase = 0;
 
     return SUCCESS;
 }
 
-int run_traffic_light(void)
+// Print a controller message. On a scaled or virtual clock every line starts
+// with the simulated time, so that a run can be followed (and compared) as a trace.
+static void report(const TrafficLight *light, SimTime now, const char *format, ...)
 {
-    while (1) // Infinite loop
+    if (light->trace == TRACE_OFF)
     {
+        return;
+    }
 
-        if (is_blinking_yellow_period())
-        {
-            handle_blinking_yellow();
-        }
+    if (light->clock->mode != CLOCK_MODE_REAL)
+    {
+        char text[32];
+        clock_format(now, text, sizeof(text));
+        printf("%s ", text);
+    }
+    if (light->trace == TRACE_WITH_ID)
+    {
+        printf("[%d] ", light->id);
+    }
 
-        if (is_night_period())
-        {
-            handle_night_period();
-            continue; // Recheck the current time after night
-        }
+    va_list arguments;
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+}
 
-        if (button_press_request())
-        {
-            pedestrian_request = true;
-        }
+// The event that ends the current phase. The day mode takes priority;
+// within the day cycle a pending pedestrian request is its own event.
+static PhaseEvent phase_event(const TrafficLight *light, DayMode mode)
+{
+    if (mode == MODE_BLINK)
+    {
+        return EVENT_BLINK;
+    }
+    if (mode == MODE_NIGHT)
+    {
+        return EVENT_NIGHT;
+    }
 
-        if (pedestrian_request)
-        {
-            printf("Pedestrian requested green light. Switching to GREEN for pedestrian.\n");
-            current_state = GREEN;
-            printf("Traffic Light: %s\n", get_light_color());
-            sleep(GREEN_DURATION);
-            pedestrian_request = false; // Reset the request after serving
-            current_state = YELLOW;     // Continue to the next state
-            continue;                   // Skip the normal state cycle this iteration
-        }
+    return light->pedestrian_request ? EVENT_PEDESTRIAN : EVENT_TIMER;
+}
 
-        printf("Traffic Light: %s\n", get_light_color());
+// Take the plan's transition for the event that ends the current phase.
+// 'cause' only goes into the binary trace.
+static const Transition *next_phase(TrafficLight *light, SimTime now, DayMode mode, TraceCause cause)
+{
+    const PhasePlan *plan = light->plan;
+    const Transition *transition = &plan->table[light->state][phase_event(light, mode)];
 
-        // Transition logic for normal day cycle
-        switch (current_state)
-        {
-        case RED:
-            sleep(RED_DURATION);
-            current_state = RED_YELLOW;
-            break;
-
-        case RED_YELLOW:
-            sleep(RED_YELLOW_DURATION);
-            current_state = GREEN;
-            break;
-
-        case GREEN:
-            sleep(GREEN_DURATION);
-            current_state = YELLOW;
-            break;
-
-        case YELLOW:
-            sleep(YELLOW_DURATION);
-            current_state = RED;
-            break;
-
-        default:
-            return INVALID_STATE;
-        }
+    if (light->log != NULL)
+    {
+        trace_ring_push(light->log, now, light->id, light->state, transition->next, cause, mode);
     }
 
-    return SUCCESS;
+    if (transition->message != 0)
+    {
+        report(light, now, "%s\n", plan->messages[transition->message]);
+    }
+    if (transition->flags & TRANSITION_SERVE)
+    {
+        light->pedestrian_request = false; // The request is served by this phase
+        atomic_store_explicit(&light->button_latched, false, memory_order_relaxed); // Presses count again
+    }
+
+    light->state = transition->next;
+    light->calls &= (uint8_t)~plan->serves[light->state]; // Those approaches have their green
+    if (!(transition->flags & TRANSITION_QUIET))
+    {
+        report(light, now, "Traffic Light: %s\n", get_light_color(light));
+    }
+
+    return transition;
 }
 
-// Handle the blinking yellow period (1 hour before night and morning)
-void handle_blinking_yellow(void)
+// A coordinated light ends its sync phase where the common cycle says, so
+// that its next main-street green starts on its offset. In step, that is
+// after the phase's own length; after a pedestrian green, a mode change or
+// a start-up the phase may be cut to half its length or stretched by up to a
+// cycle, and the light is back in step from the next green on.
+static void hold_offset(TrafficLight *light, SimTime duration)
 {
-    printf("Transition Period: Switching to BLINKING YELLOW.\n");
-    current_state = BLINKING_YELLOW;
+    const Coordination *coordination = light->coordination;
+    SimTime earliest = light->phase_start + duration / 2;
+    SimTime behind = (earliest - light->offset - coordination->sync_end) % coordination->cycle;
+    if (behind < 0)
+    {
+        behind += coordination->cycle;
+    }
 
-    for (int i = 0; i < TRANSITION_DURATION / BLINKING_YELLOW_INTERVAL; i++)
+    light->phase_deadline = (behind == 0) ? earliest : earliest + coordination->cycle - behind;
+}
+
+// A pedestrian request that has waited the plan's maximum cuts the current
+// phase short, if the state may be preempted and has run its minimum green.
+// A coordinated light serves requests within its cycle instead, since a cut
+// would throw it off its offset.
+static void preempt_phase(TrafficLight *light)
+{
+    const PedestrianPolicy *policy = &light->plan->pedestrian;
+    SimTime min_green = (SimTime)policy->min_green[light->state] * NS_PER_SECOND;
+    if (!light->pedestrian_request || min_green == 0 || light->coordination != NULL)
     {
-        printf("Traffic Light: %s\n", get_light_color());
-        sleep(BLINKING_YELLOW_INTERVAL);
+        return;
+    }
+
+    SimTime due = light->request_time + (SimTime)policy->max_wait * NS_PER_SECOND;
+    if (due < light->phase_start + min_green)
+    {
+        due = light->phase_start + min_green;
+    }
+    if (due < light->phase_deadline)
+    {
+        light->phase_deadline = due;
     }
 }
 
-// Manage the night period (OFF state)
-void handle_night_period(void)
+// Set the deadline of the phase that was just started. It is counted from the
+// previous deadline rather than from the current time, so the cycle does not
+// drift by the time it takes to handle each event. A phase entered because
+// the mode changed starts now, and after a long stall (e.g. a suspended
+// machine) the cycle restarts from now instead of replaying every missed phase.
+// A request still pending may end the phase early.
+static SimTime schedule_phase(TrafficLight *light, SimTime now, const Transition *transition, bool from_now)
 {
-    printf("Night Period: Traffic Light is OFF.\n");
-    current_state = OFF;
+    if (transition->duration == DURATION_UNTIL_MODE_CHANGE)
+    {
+        light->phase_start = now;
+        light->phase_deadline = NO_DEADLINE; // Nothing to do until the mode changes
+        return NO_DEADLINE;
+    }
+    if (transition->duration <= 0)
+    {
+        return -1;
+    }
 
-    while (is_night_period())
+    SimTime duration = (SimTime)transition->duration * NS_PER_SECOND;
+    if (from_now || light->phase_deadline + duration < now)
     {
-        printf("Traffic Light: %s\n", get_light_color());
-        sleep(10);
+        light->phase_deadline = now;
     }
 
-    // Transition to morning blinking yellow
-    handle_blinking_yellow();
+    light->phase_start = light->phase_deadline;
+    light->phase_deadline += duration;
+    if (light->coordination != NULL && light->state == light->coordination->sync_state)
+    {
+        hold_offset(light, duration);
+    }
+    preempt_phase(light);
+    return light->phase_deadline;
 }
 
-// Function to get the string representation of the current light color
-const char *get_light_color(void)
+// Start the first phase: the plan's initial state in the day mode, otherwise
+// whatever the plan enters for the blinking or night mode. A light with a
+// start phase enters the day cycle that far in, as if it had been running.
+SimTime start_traffic_light(TrafficLight *light, SimTime now, DayMode mode)
 {
-    switch (current_state)
+    if (mode != MODE_DAY)
     {
-    case RED:
-        return "RED";
-    case YELLOW:
-        return "YELLOW";
-    case GREEN:
-        return "GREEN";
-    case RED_YELLOW:
-        return "RED+YELLOW";
-    case BLINKING_YELLOW:
-        return "BLINKING YELLOW";
-    case OFF:
-        return "OFF";
-    default:
-        return "UNKNOWN";
+        return schedule_phase(light, now, next_phase(light, now, mode, TRACE_CAUSE_START), true);
     }
+
+    const PhasePlan *plan = light->plan;
+    SimTime duration = (SimTime)plan->initial_duration * NS_PER_SECOND;
+    SimTime elapsed = light->start_phase;
+    while (elapsed >= duration && duration > 0)
+    {
+        elapsed -= duration;
+        const Transition *transition = &plan->table[light->state][EVENT_TIMER];
+        light->state = transition->next;
+        duration = (SimTime)transition->duration * NS_PER_SECOND;
+    }
+
+    if (light->log != NULL)
+    {
+        trace_ring_push(light->log, now, light->id, light->state, light->state, TRACE_CAUSE_START, mode);
+    }
+    report(light, now, "Traffic Light: %s\n", get_light_color(light));
+    light->phase_start = now - elapsed;
+    light->phase_deadline = light->phase_start + duration;
+    if (light->coordination != NULL && light->state == light->coordination->sync_state)
+    {
+        hold_offset(light, duration);
+    }
+    return light->phase_deadline;
 }
 
-int button_press_request(void)
+// Carry on in the phase restored from a state file (see snapshot_restore()).
+// A phase whose deadline passed while the controller was down ends now, and
+// the cycle goes on from there.
+SimTime resume_traffic_light(TrafficLight *light, SimTime now, DayMode mode)
 {
-    fd_set read_fds; // Declare a set of file descriptors to monitor for input activity
+    if (light->phase_deadline < now)
+    {
+        light->phase_deadline = now;
+    }
+    atomic_store_explicit(&light->button_latched, light->pedestrian_request, memory_order_relaxed);
+    if (light->log != NULL)
+    {
+        trace_ring_push(light->log, now, light->id, light->state, light->state, TRACE_CAUSE_RESUME, mode);
+    }
+    report(light, now, "Traffic Light: %s (resumed)\n", get_light_color(light));
+    return light->phase_deadline;
+}
 
-    struct timeval timeout = {0, 0}; // Set a timeout for non-blocking behavior (0 seconds, 0 microseconds)
+// Approaches that get the next green the day cycle leads to from 'state'
+static uint8_t next_served(const PhasePlan *plan, int state)
+{
+    for (int i = 0; i < plan->num_states; i++)
+    {
+        state = plan->table[state][EVENT_TIMER].next;
+        if (plan->serves[state] != 0)
+        {
+            return plan->serves[state];
+        }
+    }
 
-    FD_ZERO(&read_fds);              // Initialize the file descriptor set to be empty
-    FD_SET(STDIN_FILENO, &read_fds); // Add standard input (stdin) to the file descriptor set
+    return 0;
+}
 
-    // Use select to check if there's activity (input) on stdin without blocking
-    // Parameters:
-    //   - STDIN_FILENO + 1: Range of file descriptors to monitor
-    //   - &read_fds: Set of file descriptors to monitor for readability
-    //   - NULL: No file descriptors monitored for writing
-    //   - NULL: No file descriptors monitored for exceptional conditions
-    //   - &timeout: Maximum time to wait for input (0 seconds here)
-    int activity = select(STDIN_FILENO + 1, &read_fds, NULL, NULL, &timeout);
+// The minimum of an actuated phase is over (or its last extension). The phase
+// goes on while vehicles of its approaches keep arriving within the gap, up
+// to the maximum; after that it still rests here as long as nobody waits for
+// the next green, so the green of an empty approach is skipped. Returns false
+// with the cause once the phase is over.
+static bool extend_phase(TrafficLight *light, SimTime now, TraceCause *cause)
+{
+    const PhasePlan *plan = light->plan;
+    const Actuation *actuation = &plan->actuation[light->state];
+    uint8_t served = plan->serves[light->state];
+    if (actuation->max_green == 0)
+    {
+        return false;
+    }
+
+    SimTime last = INT64_MIN / 2;
+    for (int a = 0; a < MAX_APPROACHES; a++)
+    {
+        if ((served & (1 << a)) && light->last_detection[a] > last)
+        {
+            last = light->last_detection[a];
+        }
+    }
 
-    // Check if there was activity and if stdin is ready for reading
-    if (activity > 0 && FD_ISSET(STDIN_FILENO, &read_fds))
+    SimTime gap = (SimTime)actuation->gap * NS_PER_SECOND;
+    SimTime max_end = light->phase_start + (SimTime)actuation->max_green * NS_PER_SECOND;
+    bool occupied = last + gap > now;
+    if (occupied && now < max_end)
     {
-        char input = getchar(); // Read a single character from stdin
+        light->phase_deadline = (last + gap < max_end) ? last + gap : max_end;
+        return true;
+    }
 
-        return (input == 'b' || input == 'B'); // Return 1 (true) if the character is 'b' or 'B'; otherwise, return 0
+    uint8_t waiting = next_served(plan, light->state);
+    if (waiting != 0 && !(light->calls & waiting))
+    {
+        light->phase_deadline = now + gap; // Look again after a gap
+        return true;
     }
 
-    return 0;
+    if (occupied)
+    {
+        light->calls |= served; // Cut off with vehicles left: they wait for the next green
+        *cause = TRACE_CAUSE_MAX_OUT;
+    }
+    else
+    {
+        *cause = TRACE_CAUSE_GAP_OUT;
+    }
+    return false;
 }
 
-// Check if we're in a blinking yellow period
-bool is_blinking_yellow_period(void)
+SimTime step_traffic_light(TrafficLight *light, SimTime now, DayMode mode)
 {
+    // The phase events are the first causes. A coordinated light keeps the
+    // fixed lengths of its cycle, so it is not actuated.
+    TraceCause cause = (TraceCause)phase_event(light, mode);
+    if (cause == TRACE_CAUSE_TIMER && light->coordination == NULL && extend_phase(light, now, &cause))
+    {
+        return light->phase_deadline;
+    }
 
-    time_t now = time(NULL); // Get the current time as a `time_t` value (seconds since epoch)
-    // Example output: now = 1700875800 (represents 2024-11-25 05:30:00 UTC)
+    return schedule_phase(light, now, next_phase(light, now, mode, cause), false);
+}
 
-    struct tm *local_time = localtime(&now); // Convert the time to a `tm` structure representing the local time
-    // Example output: local_time = { tm_hour = 5, tm_min = 30, tm_sec = 0, ... }
+// The mode changes on the exact second of the schedule, so the current phase
+// ends early and the new one is timed from now
+SimTime change_traffic_light_mode(TrafficLight *light, SimTime now, DayMode mode)
+{
+    return schedule_phase(light, now, next_phase(light, now, mode, TRACE_CAUSE_SCHEDULE), true);
+}
 
-    int hour = local_time->tm_hour; // Extract the hour field from the `tm` structure
-    // Example output: hour = 5
+// The request arbiter. A press while pedestrians may cross joins them, a
+// press while a request is pending is part of it, and a new request may cut
+// the current phase short (see preempt_phase()); the caller reschedules the
+// light if its phase deadline moved.
+PressResult press_button(TrafficLight *light, SimTime now)
+{
+    if (light->plan->pedestrian.walk & (1 << light->state))
+    {
+        atomic_store_explicit(&light->button_latched, false, memory_order_relaxed); // Presses count again
+        report(light, now, "Pedestrians are crossing, request joined.\n");
+        return PRESS_JOINED;
+    }
+    if (light->pedestrian_request)
+    {
+        return PRESS_PENDING;
+    }
 
-    return (hour == NIGHT_START - 1 || hour == NIGHT_END - 1); // NIGHT_START = 22, NIGHT_END = 6
-    // Example output: (hour >= 22 || hour < 6) -> true
+    light->pedestrian_request = true;
+    light->request_time = now;
+    atomic_store_explicit(&light->button_latched, true, memory_order_relaxed);
+    if (light->log != NULL)
+    {
+        trace_ring_push(light->log, now, light->id, light->state, light->state, TRACE_CAUSE_PRESS, TRACE_NO_MODE);
+    }
+    report(light, now, "Pedestrian request registered.\n");
+    preempt_phase(light);
+    return PRESS_REGISTERED;
 }
 
-// Check if it's the night period
-bool is_night_period(void)
+// A vehicle on an approach: extends its green, or calls for one
+void detect_vehicle(TrafficLight *light, SimTime now, int approach)
 {
-    time_t now = time(NULL);
-    struct tm *local_time = localtime(&now);
-    int hour = local_time->tm_hour;
+    light->last_detection[approach] = now;
+    if (!(light->plan->serves[light->state] & (1 << approach)))
+    {
+        light->calls |= (uint8_t)(1 << approach);
+    }
+}
+
+DayMode traffic_light_mode(const TrafficLight *light, DayMode scheduled)
+{
+    return (light->override_mode >= 0) ? (DayMode)light->override_mode : scheduled;
+}
+
+// The operator takes the light out of the schedule (e.g. blinking yellow for
+// road works) or hands it back; either way the new mode starts right away
+SimTime override_traffic_light(TrafficLight *light, SimTime now, int mode, DayMode scheduled)
+{
+    light->override_mode = mode;
+    if (mode >= 0)
+    {
+        report(light, now, "Operator override: %s mode.\n", day_mode_name((DayMode)mode));
+    }
+    else
+    {
+        report(light, now, "Operator override released.\n");
+    }
 
-    return (hour >= NIGHT_START || hour < NIGHT_END);
+    DayMode effective = traffic_light_mode(light, scheduled);
+    return schedule_phase(light, now, next_phase(light, now, effective, TRACE_CAUSE_OVERRIDE), true);
+}
+
+// The output of the current state, e.g. "RED+YELLOW"
+const char *get_light_color(const TrafficLight *light)
+{
+    return light->plan->state_names[light->state];
 }
@@ -0,0 +1,52 @@
+#include <math.h>
+#include "traffic_source.h"
+
+// Scramble a seed, so that neighbouring sources get unrelated sequences
+static uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Uniform in (0, 1]
+static double uniform(TrafficSource *source)
+{
+    source->random ^= source->random >> 12;
+    source->random ^= source->random << 25;
+    source->random ^= source->random >> 27;
+    uint64_t bits = (source->random * 0x2545F4914F6CDD1DULL) >> 11;
+    return ((double)bits + 1.0) / 9007199254740992.0; // 2^53
+}
+
+// Exponential gap after 'time', rounded up to the wheel tick
+static SimTime draw_arrival(TrafficSource *source, SimTime time)
+{
+    SimTime gap = (SimTime)(-log(uniform(source)) * source->mean_gap);
+    SimTime next = time + gap;
+    return (next + TIMER_TICK_NS - 1) / TIMER_TICK_NS * TIMER_TICK_NS;
+}
+
+void traffic_source_init(TrafficSource *source, int light, int intersection, int approach, double per_hour,
+                         uint64_t seed, SimTime start)
+{
+    source->timer.next = NULL;
+    source->timer.prev = NULL;
+    source->light = light;
+    source->approach = approach;
+    source->mean_gap = 3600.0 * NS_PER_SECOND / per_hour;
+    source->random = splitmix64(seed ^ splitmix64((uint64_t)intersection * (MAX_APPROACHES + 1) +
+                                                  (uint64_t)(approach + 1)));
+    if (source->random == 0)
+    {
+        source->random = 1; // xorshift never leaves zero
+    }
+    source->next = draw_arrival(source, start);
+}
+
+SimTime traffic_source_next(TrafficSource *source)
+{
+    source->next = draw_arrival(source, source->next);
+    return source->next;
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include "vehicle_queue.h"
+#include "error_codes.h"
+
+void vehicle_queue_init(VehicleQueue *queue, SimTime now)
+{
+    *queue = (VehicleQueue){0};
+    queue->last_update = now;
+    queue->next_departure = now;
+}
+
+// Add the waiting time of the queue, and the green time, up to 'time'
+static void accumulate(VehicleQueue *queue, SimTime time)
+{
+    queue->total_wait += (double)queue->length * (double)(time - queue->last_update) / NS_PER_SECOND;
+    if (queue->green)
+    {
+        queue->green_time += time - queue->last_update;
+    }
+    queue->last_update = time;
+}
+
+// A vehicle that crossed the stop line sets off for the next light
+static void depart(VehicleLink *link, SimTime time)
+{
+    if (link->count < link->capacity) // Always true, see the capacity in vehicle_link_init()
+    {
+        link->arrivals[(link->head + link->count) % link->capacity] = time + link->travel;
+        link->count++;
+    }
+}
+
+void vehicle_queue_advance(VehicleQueue *queue, SimTime now)
+{
+    while (queue->green && queue->length > 0 && queue->next_departure <= now)
+    {
+        accumulate(queue, queue->next_departure);
+        queue->length--;
+        queue->served++;
+        if (queue->downstream != NULL)
+        {
+            depart(queue->downstream, queue->next_departure);
+        }
+        queue->next_departure += SATURATION_HEADWAY;
+    }
+
+    accumulate(queue, now);
+}
+
+void vehicle_queue_arrive(VehicleQueue *queue, SimTime now)
+{
+    vehicle_queue_advance(queue, now);
+    if (!queue->green || queue->length > 0)
+    {
+        queue->stops++;
+    }
+
+    // On green, a vehicle that finds no queue goes as soon as the one before it is clear
+    if (queue->green && queue->length == 0 && queue->next_departure < now)
+    {
+        queue->next_departure = now;
+    }
+
+    queue->length++;
+    queue->arrived++;
+    if (queue->length > queue->max_length)
+    {
+        queue->max_length = queue->length;
+    }
+
+    vehicle_queue_advance(queue, now);
+}
+
+void vehicle_queue_set_green(VehicleQueue *queue, SimTime now, bool green)
+{
+    vehicle_queue_advance(queue, now);
+    if (green && !queue->green)
+    {
+        queue->next_departure = now + START_UP_LOST_TIME;
+    }
+    queue->green = green;
+}
+
+SimTime vehicle_queue_next_departure(const VehicleQueue *queue)
+{
+    return (queue->green && queue->length > 0) ? queue->next_departure : INT64_MAX;
+}
+
+// Vehicles leave 'from' at least a headway apart, so at most travel / headway
+// + 1 of them are on the way at once
+int vehicle_link_init(VehicleLink *link, VehicleQueue *from, int light, int approach, SimTime travel)
+{
+    link->from = from;
+    link->light = light;
+    link->approach = approach;
+    link->travel = travel;
+    link->capacity = (int)(travel / SATURATION_HEADWAY) + 2;
+    link->head = 0;
+    link->count = 0;
+    link->arrivals = malloc((size_t)link->capacity * sizeof(SimTime));
+    if (link->arrivals == NULL)
+    {
+        return UNKNOWN_ERROR;
+    }
+
+    from->downstream = link;
+    return SUCCESS;
+}
+
+void vehicle_link_free(VehicleLink *link)
+{
+    free(link->arrivals);
+    link->arrivals = NULL;
+}
+
+SimTime vehicle_link_pop(VehicleLink *link)
+{
+    SimTime time = link->arrivals[link->head];
+    link->head = (link->head + 1) % link->capacity;
+    link->count--;
+    return time;
+}